@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace mata {
@@ -53,15 +56,127 @@ public:
              {position.x + dimensions.width, position.y}) {}
 };
 
-template <typename T> class GridContainer {
-private:
+// Layouts map the indices of a GridContainer to offsets into its storage.
+// Each is constructed from the grid's dimensions and says how many elements
+// of storage it needs, which can be more than the grid has cells.
+
+// Rows one after another: cheap to index, but cells above and below each
+// other are a whole row apart.
+class RowMajorLayout {
   GridDimensions2d m_dimensions;
-  std::vector<T> m_elements;
 
-  constexpr std::size_t index1d(const Index2d &index) const noexcept {
-    return static_cast<std::size_t>(index2dTo1d(index, m_dimensions));
+public:
+  constexpr explicit RowMajorLayout(
+      const GridDimensions2d &dimensions) noexcept
+      : m_dimensions(dimensions) {}
+
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return static_cast<std::size_t>(m_dimensions.nColumns) *
+           static_cast<std::size_t>(m_dimensions.nRows);
   }
 
+  [[nodiscard]] constexpr std::size_t
+  offset(const Index2d &index) const noexcept {
+    return static_cast<std::size_t>(m_dimensions.nColumns) *
+               static_cast<std::size_t>(index.j) +
+           static_cast<std::size_t>(index.i);
+  }
+};
+
+// Square tiles of TILE_SIZE x TILE_SIZE cells stored one after another, row
+// major within each tile and tile rows one after another. Code that works a
+// tile at a time, such as building a chunk's mesh, reads one contiguous
+// block. Edge tiles are padded to full size.
+template <int TILE_SIZE> class TiledLayout {
+  static_assert(TILE_SIZE > 0, "tiles need at least one cell");
+  static constexpr auto TILE_AREA =
+      static_cast<std::size_t>(TILE_SIZE) * static_cast<std::size_t>(TILE_SIZE);
+
+  std::size_t m_nTileColumns;
+  std::size_t m_nTileRows;
+
+public:
+  constexpr explicit TiledLayout(const GridDimensions2d &dimensions) noexcept
+      : m_nTileColumns(
+            static_cast<std::size_t>((dimensions.nColumns + TILE_SIZE - 1) /
+                                     TILE_SIZE)),
+        m_nTileRows(static_cast<std::size_t>(
+            (dimensions.nRows + TILE_SIZE - 1) / TILE_SIZE)) {}
+
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return m_nTileColumns * m_nTileRows * TILE_AREA;
+  }
+
+  [[nodiscard]] constexpr std::size_t
+  offset(const Index2d &index) const noexcept {
+    const auto tile =
+        static_cast<std::size_t>(index.j / TILE_SIZE) * m_nTileColumns +
+        static_cast<std::size_t>(index.i / TILE_SIZE);
+    const auto cell =
+        static_cast<std::size_t>((index.j % TILE_SIZE) * TILE_SIZE +
+                                 index.i % TILE_SIZE);
+    return tile * TILE_AREA + cell;
+  }
+};
+
+// A Z-order (Morton) curve, interleaving the bits of i and j so that cells
+// near each other in both directions are near each other in memory at every
+// scale, without picking a tile size. Dimensions are padded to powers of
+// two; past the shorter one's bits, the longer one's high bits select
+// consecutive square Z-curves.
+class MortonLayout {
+  unsigned int m_nColumnBits;
+  unsigned int m_nRowBits;
+
+  [[nodiscard]] static constexpr unsigned int bitsFor(const int n) noexcept {
+    auto nBits = 0u;
+    while ((std::size_t{1} << nBits) < static_cast<std::size_t>(n)) {
+      nBits++;
+    }
+    return nBits;
+  }
+
+  // Spread the low 32 bits of n out to the even bits.
+  [[nodiscard]] static constexpr std::uint64_t
+  spreadBits(std::uint64_t n) noexcept {
+    n &= 0xffffffffu;
+    n = (n | (n << 16)) & 0x0000ffff0000ffffu;
+    n = (n | (n << 8)) & 0x00ff00ff00ff00ffu;
+    n = (n | (n << 4)) & 0x0f0f0f0f0f0f0f0fu;
+    n = (n | (n << 2)) & 0x3333333333333333u;
+    n = (n | (n << 1)) & 0x5555555555555555u;
+    return n;
+  }
+
+public:
+  constexpr explicit MortonLayout(const GridDimensions2d &dimensions) noexcept
+      : m_nColumnBits(bitsFor(dimensions.nColumns)),
+        m_nRowBits(bitsFor(dimensions.nRows)) {}
+
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return std::size_t{1} << (m_nColumnBits + m_nRowBits);
+  }
+
+  [[nodiscard]] constexpr std::size_t
+  offset(const Index2d &index) const noexcept {
+    const auto nSharedBits = std::min(m_nColumnBits, m_nRowBits);
+    const auto mask = (std::uint64_t{1} << nSharedBits) - 1;
+    const auto i = static_cast<std::uint64_t>(index.i);
+    const auto j = static_cast<std::uint64_t>(index.j);
+    // Only the longer dimension has bits past the shared ones.
+    const auto high = ((i >> nSharedBits) | (j >> nSharedBits))
+                      << (2 * nSharedBits);
+    return static_cast<std::size_t>(
+        high | spreadBits(i & mask) | (spreadBits(j & mask) << 1));
+  }
+};
+
+template <typename T, typename Layout = RowMajorLayout> class GridContainer {
+private:
+  GridDimensions2d m_dimensions;
+  Layout m_layout;
+  std::vector<T> m_elements;
+
   constexpr bool indexInRange(const Index2d &index) const noexcept {
     return index.i >= 0 && index.j >= 0 && index.i < m_dimensions.nColumns &&
            index.j < m_dimensions.nRows;
@@ -69,26 +184,190 @@ private:
 
 public:
   constexpr explicit GridContainer(const GridDimensions2d &dimensions) noexcept
-      : m_dimensions(dimensions),
-        m_elements(
-            static_cast<std::size_t>(dimensions.nColumns * dimensions.nRows)) {}
+      : m_dimensions(dimensions), m_layout(dimensions),
+        m_elements(m_layout.size()) {}
 
+  // Elements are given row by row, whatever the layout.
   constexpr GridContainer(const GridDimensions2d &dimensions,
                           const std::vector<T> &elements) noexcept
       : GridContainer(dimensions) {
-    m_elements.assign(elements.begin(), elements.end());
+    assert(elements.size() == static_cast<std::size_t>(dimensions.nColumns) *
+                                  static_cast<std::size_t>(dimensions.nRows));
+    auto element = elements.begin();
+    for (auto j = 0; j < dimensions.nRows; j++) {
+      for (auto i = 0; i < dimensions.nColumns; i++) {
+        m_elements[m_layout.offset({i, j})] = *element++;
+      }
+    }
+  }
+
+  [[nodiscard]] constexpr GridDimensions2d dimensions() const noexcept {
+    return m_dimensions;
   }
 
   constexpr void set(const Index2d &index, const T &value) noexcept {
     assert(indexInRange(index));
 
-    m_elements[index1d(index)] = value;
+    m_elements[m_layout.offset(index)] = value;
   }
 
+  // Bounds checked against the storage as well in release builds.
   constexpr const T &at(const Index2d &index) const noexcept {
     assert(indexInRange(index));
 
-    return m_elements.at(index1d(index));
+    return m_elements.at(m_layout.offset(index));
+  }
+
+  // Unchecked outside of debug builds, for loops that keep to the grid.
+  constexpr T &operator[](const Index2d &index) noexcept {
+    assert(indexInRange(index));
+    return m_elements[m_layout.offset(index)];
+  }
+  constexpr const T &operator[](const Index2d &index) const noexcept {
+    assert(indexInRange(index));
+    return m_elements[m_layout.offset(index)];
+  }
+
+  // Call back with the origin and dimensions of each chunk of a grid split
+  // into chunkSize chunks, row by row. Chunks on the far edges are cut
+  // short.
+  template <typename Callback>
+  constexpr void forEachChunk(const GridDimensions2d &chunkSize,
+                              Callback &&callback) const {
+    assert(chunkSize.nColumns > 0 && chunkSize.nRows > 0);
+    for (auto j = 0; j < m_dimensions.nRows; j += chunkSize.nRows) {
+      for (auto i = 0; i < m_dimensions.nColumns; i += chunkSize.nColumns) {
+        callback(Index2d{i, j},
+                 GridDimensions2d{
+                     std::min(chunkSize.nColumns, m_dimensions.nColumns - i),
+                     std::min(chunkSize.nRows, m_dimensions.nRows - j)});
+      }
+    }
+  }
+
+  // Call back with the index and element of each cell of a rectangle,
+  // which is clipped to the grid, row by row.
+  template <typename Callback>
+  constexpr void forEachIn(const Index2d &origin,
+                           const GridDimensions2d &dimensions,
+                           Callback &&callback) const {
+    const auto begin = Index2d{std::max(origin.i, 0), std::max(origin.j, 0)};
+    const auto end = Index2d{
+        std::min(origin.i + dimensions.nColumns, m_dimensions.nColumns),
+        std::min(origin.j + dimensions.nRows, m_dimensions.nRows)};
+    for (auto j = begin.j; j < end.j; j++) {
+      for (auto i = begin.i; i < end.i; i++) {
+        const auto index = Index2d{i, j};
+        callback(index, m_elements[m_layout.offset(index)]);
+      }
+    }
+  }
+};
+
+// A grid split into CHUNK_SIZE x CHUNK_SIZE chunks, where only chunks that
+// have held an element other than the fill value take any memory; every
+// other cell reads as the fill value. Meant for grids that are mostly fill,
+// where memory should follow the number of elements set rather than the
+// size of the grid.
+template <typename T, int CHUNK_SIZE> class SparseGridContainer {
+  static_assert(CHUNK_SIZE > 0, "chunks need at least one cell");
+  static constexpr auto CHUNK_AREA = static_cast<std::size_t>(CHUNK_SIZE) *
+                                     static_cast<std::size_t>(CHUNK_SIZE);
+
+private:
+  GridDimensions2d m_dimensions;
+  GridDimensions2d m_nChunks;
+  T m_fill;
+  // Empty until the chunk is allocated, then CHUNK_AREA elements, row major.
+  std::vector<std::vector<T>> m_chunks;
+
+  constexpr bool indexInRange(const Index2d &index) const noexcept {
+    return index.i >= 0 && index.j >= 0 && index.i < m_dimensions.nColumns &&
+           index.j < m_dimensions.nRows;
+  }
+
+  static constexpr std::size_t cellOffset(const Index2d &index) noexcept {
+    return static_cast<std::size_t>((index.j % CHUNK_SIZE) * CHUNK_SIZE +
+                                    index.i % CHUNK_SIZE);
+  }
+
+  const std::vector<T> &chunkOf(const Index2d &index) const noexcept {
+    return m_chunks[static_cast<std::size_t>(index2dTo1d(
+        {index.i / CHUNK_SIZE, index.j / CHUNK_SIZE}, m_nChunks))];
+  }
+  std::vector<T> &chunkOf(const Index2d &index) noexcept {
+    return m_chunks[static_cast<std::size_t>(index2dTo1d(
+        {index.i / CHUNK_SIZE, index.j / CHUNK_SIZE}, m_nChunks))];
+  }
+
+public:
+  explicit SparseGridContainer(const GridDimensions2d &dimensions,
+                               const T &fill = T{})
+      : m_dimensions(dimensions),
+        m_nChunks({(dimensions.nColumns + CHUNK_SIZE - 1) / CHUNK_SIZE,
+                   (dimensions.nRows + CHUNK_SIZE - 1) / CHUNK_SIZE}),
+        m_fill(fill), m_chunks(static_cast<std::size_t>(m_nChunks.nColumns) *
+                               static_cast<std::size_t>(m_nChunks.nRows)) {}
+
+  // Elements are given row by row; only chunks with an element other than
+  // fill are allocated.
+  SparseGridContainer(const GridDimensions2d &dimensions,
+                      const std::vector<T> &elements, const T &fill = T{})
+      : SparseGridContainer(dimensions, fill) {
+    assert(elements.size() == static_cast<std::size_t>(dimensions.nColumns) *
+                                  static_cast<std::size_t>(dimensions.nRows));
+    auto element = elements.begin();
+    for (auto j = 0; j < dimensions.nRows; j++) {
+      for (auto i = 0; i < dimensions.nColumns; i++) {
+        set({i, j}, *element++);
+      }
+    }
+  }
+
+  [[nodiscard]] GridDimensions2d dimensions() const noexcept {
+    return m_dimensions;
+  }
+
+  [[nodiscard]] GridDimensions2d nChunks() const noexcept { return m_nChunks; }
+
+  [[nodiscard]] const T &fill() const noexcept { return m_fill; }
+
+  // Setting a cell to anything but fill allocates its chunk. Chunks are kept
+  // once allocated, even if every cell is set back to fill.
+  void set(const Index2d &index, const T &value) {
+    assert(indexInRange(index));
+
+    auto &chunk = chunkOf(index);
+    if (chunk.empty()) {
+      if (value == m_fill) {
+        return;
+      }
+      chunk.assign(CHUNK_AREA, m_fill);
+    }
+    chunk[cellOffset(index)] = value;
+  }
+
+  // Unchecked outside of debug builds.
+  [[nodiscard]] const T &operator[](const Index2d &index) const noexcept {
+    assert(indexInRange(index));
+
+    const auto &chunk = chunkOf(index);
+    return chunk.empty() ? m_fill : chunk[cellOffset(index)];
+  }
+
+  [[nodiscard]] bool isChunkAllocated(const Index2d &chunk) const noexcept {
+    assert(chunk.i >= 0 && chunk.j >= 0 && chunk.i < m_nChunks.nColumns &&
+           chunk.j < m_nChunks.nRows);
+    return !m_chunks[static_cast<std::size_t>(index2dTo1d(chunk, m_nChunks))]
+                .empty();
+  }
+
+  [[nodiscard]] std::size_t nAllocatedChunks() const noexcept {
+    return static_cast<std::size_t>(
+        std::count_if(m_chunks.begin(), m_chunks.end(),
+                      [](const std::vector<T> &chunk) {
+                        return !chunk.empty();
+                      }));
   }
 };
 
@@ -0,0 +1,36 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+#include "types.hpp"
+
+namespace mata {
+namespace core {
+
+// Integers in mata's file formats are stored little endian, byte by byte, so
+// they can be read from any offset regardless of alignment or host order.
+template <typename T>
+[[nodiscard]] T readLittleEndian(const byte *pBytes) noexcept {
+  static_assert(std::is_unsigned_v<T>);
+  auto value = T{0};
+  for (auto i = std::size_t{0}; i < sizeof(T); i++) {
+    value = static_cast<T>(value | (static_cast<T>(pBytes[i]) << (8 * i)));
+  }
+  return value;
+}
+
+template <typename T>
+void writeLittleEndian(byte *pBytes, const T value) noexcept {
+  static_assert(std::is_unsigned_v<T>);
+  for (auto i = std::size_t{0}; i < sizeof(T); i++) {
+    pBytes[i] = static_cast<byte>((value >> (8 * i)) & 0xff);
+  }
+}
+
+} // namespace core
+} // namespace mata
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 namespace mata {
@@ -12,5 +13,29 @@ namespace core {
 using byte = unsigned char;
 using bytes = std::vector<byte>;
 
+// A read-only view of contiguous bytes owned by something else, such as a
+// bytes vector or a memory mapped file.
+class bytes_view final {
+  const byte *m_data = nullptr;
+  std::size_t m_size = 0;
+
+public:
+  constexpr bytes_view() noexcept = default;
+  constexpr bytes_view(const byte *data, const std::size_t size) noexcept
+      : m_data(data), m_size(size) {}
+  // Implicit so that functions taking a view also accept bytes.
+  bytes_view(const bytes &owner) noexcept
+      : m_data(owner.data()), m_size(owner.size()) {}
+
+  [[nodiscard]] constexpr const byte *data() const noexcept { return m_data; }
+  [[nodiscard]] constexpr std::size_t size() const noexcept { return m_size; }
+  [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+
+  [[nodiscard]] constexpr const byte *begin() const noexcept { return m_data; }
+  [[nodiscard]] constexpr const byte *end() const noexcept {
+    return m_data + m_size;
+  }
+};
+
 } // namespace core
 } // namespace mata
@@ -0,0 +1,168 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <mata/core/geometry.hpp>
+
+namespace {
+
+// Non-square and not powers of two, so that edge tiles are padded and
+// Morton offsets use the longer dimension's high bits, either way round.
+mata::core::GridDimensions2d gridDimensions() {
+  return GENERATE(mata::core::GridDimensions2d{37, 5},
+                  mata::core::GridDimensions2d{5, 37});
+}
+
+} // namespace
+
+TEMPLATE_TEST_CASE("Grid layouts", "[geometry]", mata::core::RowMajorLayout,
+                   mata::core::TiledLayout<4>, mata::core::MortonLayout) {
+  const auto dimensions = gridDimensions();
+  CAPTURE(dimensions.nColumns, dimensions.nRows);
+  const auto nCells = dimensions.nColumns * dimensions.nRows;
+
+  SECTION("offsets are unique and within the storage") {
+    const auto layout = TestType(dimensions);
+    REQUIRE(layout.size() >= static_cast<std::size_t>(nCells));
+    auto isUsed = std::vector<bool>(layout.size());
+    for (auto j = 0; j < dimensions.nRows; j++) {
+      for (auto i = 0; i < dimensions.nColumns; i++) {
+        CAPTURE(i, j);
+        const auto offset = layout.offset({i, j});
+        REQUIRE(offset < layout.size());
+        REQUIRE_FALSE(isUsed[offset]);
+        isUsed[offset] = true;
+      }
+    }
+  }
+
+  auto elements = std::vector<int>(static_cast<std::size_t>(nCells));
+  for (auto n = 0; n < nCells; n++) {
+    elements[static_cast<std::size_t>(n)] = n;
+  }
+  const auto grid =
+      mata::core::GridContainer<int, TestType>(dimensions, elements);
+
+  SECTION("elements are given row by row") {
+    for (auto j = 0; j < dimensions.nRows; j++) {
+      for (auto i = 0; i < dimensions.nColumns; i++) {
+        REQUIRE(grid[{i, j}] == mata::core::index2dTo1d({i, j}, dimensions));
+        REQUIRE(grid.at({i, j}) ==
+                mata::core::index2dTo1d({i, j}, dimensions));
+      }
+    }
+  }
+
+  SECTION("chunks cover every cell once, row by row") {
+    auto nVisits = std::vector<int>(static_cast<std::size_t>(nCells));
+    auto lastOrigin = mata::core::Index2d{-1, -1};
+    grid.forEachChunk({8, 3}, [&](const mata::core::Index2d &origin,
+                                  const mata::core::GridDimensions2d &size) {
+      REQUIRE((origin.j > lastOrigin.j ||
+               (origin.j == lastOrigin.j && origin.i > lastOrigin.i)));
+      lastOrigin = origin;
+      REQUIRE(size.nColumns == std::min(8, dimensions.nColumns - origin.i));
+      REQUIRE(size.nRows == std::min(3, dimensions.nRows - origin.j));
+      for (auto j = origin.j; j < origin.j + size.nRows; j++) {
+        for (auto i = origin.i; i < origin.i + size.nColumns; i++) {
+          nVisits[static_cast<std::size_t>(
+              mata::core::index2dTo1d({i, j}, dimensions))]++;
+        }
+      }
+    });
+    REQUIRE(std::all_of(nVisits.begin(), nVisits.end(),
+                        [](const int n) { return n == 1; }));
+  }
+
+  SECTION("rectangles are clipped to the grid") {
+    const auto nColumns = dimensions.nColumns;
+    const auto nRows = dimensions.nRows;
+    // Inside, past each edge, past every edge, and wholly outside.
+    using Rectangle =
+        std::pair<mata::core::Index2d, mata::core::GridDimensions2d>;
+    const auto rectangles = std::vector<Rectangle>{
+        {{0, 0}, {1, 1}},
+        {{1, 1}, {nColumns - 2, nRows - 2}},
+        {{-3, 0}, {5, nRows}},
+        {{0, -3}, {nColumns, 5}},
+        {{nColumns - 2, 0}, {5, nRows}},
+        {{0, nRows - 2}, {nColumns, 5}},
+        {{-10, -10}, {nColumns + 20, nRows + 20}},
+        {{nColumns, 0}, {3, 3}},
+        {{0, -3}, {3, 3}},
+    };
+    for (const auto &[origin, size] : rectangles) {
+      CAPTURE(origin.i, origin.j, size.nColumns, size.nRows);
+      auto expected = std::vector<int>{};
+      for (auto j = 0; j < nRows; j++) {
+        for (auto i = 0; i < nColumns; i++) {
+          if (i >= origin.i && i < origin.i + size.nColumns &&
+              j >= origin.j && j < origin.j + size.nRows) {
+            expected.push_back(mata::core::index2dTo1d({i, j}, dimensions));
+          }
+        }
+      }
+      auto visited = std::vector<int>{};
+      grid.forEachIn(origin, size,
+                     [&](const mata::core::Index2d &index, const int element) {
+                       REQUIRE(element ==
+                               mata::core::index2dTo1d(index, dimensions));
+                       visited.push_back(element);
+                     });
+      REQUIRE(visited == expected);
+    }
+  }
+}
+
+TEST_CASE("Sparse grid container", "[geometry]") {
+  // 10x7 cells in 4x4 chunks, so the last column and row of chunks are cut
+  // short by the grid's edges.
+  auto grid = mata::core::SparseGridContainer<int, 4>({10, 7}, -1);
+  REQUIRE(grid.nChunks().nColumns == 3);
+  REQUIRE(grid.nChunks().nRows == 2);
+  REQUIRE(grid.nAllocatedChunks() == 0);
+  REQUIRE(grid[{0, 0}] == -1);
+  REQUIRE(grid[{9, 6}] == -1);
+
+  SECTION("setting fill allocates nothing") {
+    grid.set({5, 5}, -1);
+    REQUIRE(grid.nAllocatedChunks() == 0);
+  }
+
+  SECTION("setting a value allocates only its chunk") {
+    grid.set({9, 6}, 7);
+    REQUIRE(grid[{9, 6}] == 7);
+    REQUIRE(grid[{8, 6}] == -1);
+    REQUIRE(grid[{9, 5}] == -1);
+    REQUIRE(grid.isChunkAllocated({2, 1}));
+    REQUIRE_FALSE(grid.isChunkAllocated({1, 1}));
+    REQUIRE_FALSE(grid.isChunkAllocated({2, 0}));
+    REQUIRE(grid.nAllocatedChunks() == 1);
+
+    // Chunks are kept once allocated.
+    grid.set({9, 6}, -1);
+    REQUIRE(grid[{9, 6}] == -1);
+    REQUIRE(grid.isChunkAllocated({2, 1}));
+  }
+
+  SECTION("elements are given row by row") {
+    auto elements = std::vector<int>(10 * 7, -1);
+    elements[3 * 10 + 4] = 1;
+    elements[6 * 10 + 0] = 2;
+    const auto filled =
+        mata::core::SparseGridContainer<int, 4>({10, 7}, elements, -1);
+    REQUIRE(filled[{4, 3}] == 1);
+    REQUIRE(filled[{0, 6}] == 2);
+    REQUIRE(filled[{3, 4}] == -1);
+    REQUIRE(filled.isChunkAllocated({1, 0}));
+    REQUIRE(filled.isChunkAllocated({0, 1}));
+    REQUIRE(filled.nAllocatedChunks() == 2);
+  }
+}
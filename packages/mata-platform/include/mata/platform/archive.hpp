@@ -0,0 +1,63 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+
+#include <mata/utils/propagate_const.hpp>
+
+#include "mapped_file.hpp"
+
+namespace mata {
+namespace platform {
+
+// A read-only pack of files, mapped into memory as a whole. Its table of
+// contents is sorted by path, so finding a file is a binary search that
+// makes no system calls.
+//
+// Layout, with integers stored little endian:
+//
+//   header     magic "MATAPAK\0", u32 version, u32 nEntries,
+//              u64 namesOffset, u64 namesSize
+//   entries    nEntries x { u64 nameOffset, u32 nameSize, u32 compression,
+//                           u64 dataOffset, u64 storedSize, u64 size },
+//              sorted by name
+//   names      the entries' generic relative paths, back to back
+//   data       each entry's bytes, aligned to ENTRY_ALIGNMENT
+class Archive final {
+  class Impl;
+  MATA_PROPAGATE_CONST(std::unique_ptr<Impl>) m_pImpl;
+
+public:
+  // Entries start on cache line boundaries, so they can be read in place
+  // from the mapping.
+  static constexpr std::size_t ENTRY_ALIGNMENT = 64;
+
+  explicit Archive(const std::filesystem::path &path);
+  ~Archive() noexcept;
+
+  Archive(Archive &&other) noexcept;
+  Archive &operator=(Archive &&other) noexcept;
+
+  [[nodiscard]] std::size_t nEntries() const noexcept;
+
+  [[nodiscard]] bool contains(const std::filesystem::path &path) const;
+
+  // The entry's bytes as a view of the archive's mapping, or nothing if the
+  // archive has no such entry.
+  [[nodiscard]] std::optional<MappedFile>
+  find(const std::filesystem::path &path) const;
+
+  // Pack every regular file under directory into a new archive at
+  // archivePath, using paths relative to directory as entry names.
+  static void pack(const std::filesystem::path &directory,
+                   const std::filesystem::path &archivePath);
+};
+
+} // namespace platform
+} // namespace mata
@@ -0,0 +1,44 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+
+#include <mata/core/types.hpp>
+#include <mata/utils/propagate_const.hpp>
+
+namespace mata {
+namespace platform {
+
+// A file, or a range of one, mapped read-only into memory. Pages are read
+// from disk as they're first touched, and nothing is copied into the process.
+class MappedFile final {
+  class Impl;
+  class Mapping;
+  MATA_PROPAGATE_CONST(std::unique_ptr<Impl>) m_pImpl;
+
+  explicit MappedFile(std::unique_ptr<Impl> pImpl) noexcept;
+
+public:
+  explicit MappedFile(const std::filesystem::path &path);
+  ~MappedFile() noexcept;
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  // The view is valid for the lifetime of the mapping.
+  [[nodiscard]] mata::core::bytes_view bytes() const noexcept;
+  [[nodiscard]] std::size_t size() const noexcept;
+
+  // A range of this file that keeps the whole mapping alive for as long as
+  // either of them needs it.
+  [[nodiscard]] MappedFile slice(const std::size_t offset,
+                                 const std::size_t size) const;
+};
+
+} // namespace platform
+} // namespace mata
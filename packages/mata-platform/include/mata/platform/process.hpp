@@ -0,0 +1,16 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+
+namespace mata {
+namespace platform {
+
+// The most physical memory the process has used at once so far, in bytes.
+[[nodiscard]] std::size_t peakResidentSetSize();
+
+} // namespace platform
+} // namespace mata
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
 #include <memory>
 #include <string>
@@ -11,21 +12,53 @@
 #include <mata/core/types.hpp>
 #include <mata/utils/propagate_const.hpp>
 
+#include "mapped_file.hpp"
+
 namespace mata {
 namespace platform {
 
+// Files looked up by paths relative to a set of mounted roots, each either a
+// directory of loose files or an Archive packed from one.
 class VirtualFileSystem final {
   class Impl;
   MATA_PROPAGATE_CONST(std::unique_ptr<Impl>) m_pImpl;
 
 public:
+  static constexpr std::size_t DEFAULT_CACHE_CAPACITY = 64 * 1024 * 1024;
+
+  struct CacheStats {
+    std::size_t nHits = 0;
+    std::size_t nMisses = 0;
+    std::size_t nEvictions = 0;
+    // The size of the files currently cached.
+    std::size_t nBytes = 0;
+  };
+
   explicit VirtualFileSystem(const std::filesystem::path &rootPath);
   ~VirtualFileSystem() noexcept;
 
+  // Mount another root over the existing ones. Files are looked up in the
+  // most recently mounted root first, so a patch directory mounted over a
+  // base archive overrides the files in it. Mounting must not happen while
+  // other threads are reading.
+  void mount(const std::filesystem::path &rootPath);
+
   [[nodiscard]] mata::core::bytes
   readFile(const std::filesystem::path &path) const;
   [[nodiscard]] std::string
   readTextFile(const std::filesystem::path &path) const;
+  // Map the file into memory instead of reading it, for large files or ones
+  // that are only needed briefly.
+  [[nodiscard]] MappedFile mapFile(const std::filesystem::path &path) const;
+
+  // Read a file through a least recently used cache of file contents, which
+  // is bounded by its capacity in bytes. Buffers are shared with the cache
+  // and every other reader of the file, so repeated reads don't copy.
+  [[nodiscard]] std::shared_ptr<const mata::core::bytes>
+  readSharedFile(const std::filesystem::path &path) const;
+  void setCacheCapacity(const std::size_t nBytes);
+  void clearCache();
+  [[nodiscard]] CacheStats cacheStats() const;
 };
 
 } // namespace platform
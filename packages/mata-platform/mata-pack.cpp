@@ -0,0 +1,25 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <exception>
+#include <filesystem>
+#include <iostream>
+
+#include <mata/platform/archive.hpp>
+
+// Usage: mata-pack <directory> <archive>
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <directory> <archive>\n";
+    return 1;
+  }
+
+  try {
+    mata::platform::Archive::pack(argv[1], argv[2]);
+  } catch (const std::exception &error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,270 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <mata/core/little_endian.hpp>
+#include <mata/core/types.hpp>
+
+#include "mata/platform/archive.hpp"
+#include "mata/platform/mapped_file.hpp"
+
+namespace mata {
+namespace platform {
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC = {'M', 'A', 'T', 'A', 'P', 'A', 'K', '\0'};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 32;
+constexpr std::size_t ENTRY_SIZE = 40;
+
+enum class Compression : std::uint32_t {
+  Stored = 0,
+};
+
+using mata::core::readLittleEndian;
+
+template <typename T>
+void writeLittleEndian(std::ostream &output, const T value) {
+  auto bytes = std::array<mata::core::byte, sizeof(T)>{};
+  mata::core::writeLittleEndian(bytes.data(), value);
+  output.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+}
+
+std::string entryName(const std::filesystem::path &path) {
+  return path.lexically_normal().generic_string();
+}
+
+struct Entry {
+  std::string_view name;
+  Compression compression;
+  std::uint64_t dataOffset;
+  std::uint64_t storedSize;
+  std::uint64_t size;
+};
+
+} // namespace
+
+class Archive::Impl final {
+  std::filesystem::path m_path;
+  MappedFile m_file;
+  std::size_t m_nEntries = 0;
+  const mata::core::byte *m_pEntries = nullptr;
+  const char *m_pNames = nullptr;
+
+  [[noreturn]] void throwCorrupt(const std::string_view reason) const {
+    throw std::runtime_error(fmt::format("corrupt archive {0}: {1}",
+                                         m_path.string(), reason));
+  }
+
+  Entry entryAt(const std::size_t index) const noexcept {
+    const auto pEntry = m_pEntries + ENTRY_SIZE * index;
+    const auto nameOffset = readLittleEndian<std::uint64_t>(pEntry);
+    const auto nameSize = readLittleEndian<std::uint32_t>(pEntry + 8);
+    return {std::string_view(m_pNames + nameOffset, nameSize),
+            static_cast<Compression>(
+                readLittleEndian<std::uint32_t>(pEntry + 12)),
+            readLittleEndian<std::uint64_t>(pEntry + 16),
+            readLittleEndian<std::uint64_t>(pEntry + 24),
+            readLittleEndian<std::uint64_t>(pEntry + 32)};
+  }
+
+  std::optional<Entry> findEntry(const std::filesystem::path &path) const {
+    const auto name = entryName(path);
+    auto first = std::size_t{0};
+    auto count = m_nEntries;
+    while (count > 0) {
+      const auto step = count / 2;
+      if (entryAt(first + step).name < name) {
+        first += step + 1;
+        count -= step + 1;
+      } else {
+        count = step;
+      }
+    }
+    if (first == m_nEntries || entryAt(first).name != name) {
+      return std::nullopt;
+    }
+    return entryAt(first);
+  }
+
+  // Check the whole table of contents once so that lookups can trust it.
+  void validate() {
+    const auto bytes = m_file.bytes();
+    if (bytes.size() < HEADER_SIZE ||
+        std::memcmp(bytes.data(), MAGIC.data(), MAGIC.size()) != 0) {
+      throwCorrupt("not an archive");
+    }
+    const auto version = readLittleEndian<std::uint32_t>(bytes.data() + 8);
+    if (version != VERSION) {
+      throwCorrupt(fmt::format("unsupported version {0}", version));
+    }
+    m_nEntries = readLittleEndian<std::uint32_t>(bytes.data() + 12);
+    const auto namesOffset = readLittleEndian<std::uint64_t>(bytes.data() + 16);
+    const auto namesSize = readLittleEndian<std::uint64_t>(bytes.data() + 24);
+    if (HEADER_SIZE + ENTRY_SIZE * m_nEntries > namesOffset ||
+        namesOffset > bytes.size() || namesSize > bytes.size() - namesOffset) {
+      throwCorrupt("table of contents out of bounds");
+    }
+    m_pEntries = bytes.data() + HEADER_SIZE;
+    m_pNames = reinterpret_cast<const char *>(bytes.data() + namesOffset);
+
+    for (auto i = std::size_t{0}; i < m_nEntries; i++) {
+      const auto pEntry = m_pEntries + ENTRY_SIZE * i;
+      const auto nameOffset = readLittleEndian<std::uint64_t>(pEntry);
+      const auto nameSize = readLittleEndian<std::uint32_t>(pEntry + 8);
+      if (nameOffset > namesSize || nameSize > namesSize - nameOffset) {
+        throwCorrupt("entry name out of bounds");
+      }
+      const auto entry = entryAt(i);
+      if (entry.dataOffset > bytes.size() ||
+          entry.storedSize > bytes.size() - entry.dataOffset) {
+        throwCorrupt(fmt::format("entry {0} out of bounds", entry.name));
+      }
+      if (i > 0 && !(entryAt(i - 1).name < entry.name)) {
+        throwCorrupt("entries are not sorted");
+      }
+    }
+  }
+
+public:
+  Impl(const std::filesystem::path &path) : m_path(path), m_file(path) {
+    this->validate();
+  }
+
+  std::size_t nEntries() const noexcept { return m_nEntries; }
+
+  bool contains(const std::filesystem::path &path) const {
+    return this->findEntry(path).has_value();
+  }
+
+  std::optional<MappedFile> find(const std::filesystem::path &path) const {
+    const auto entry = this->findEntry(path);
+    if (!entry) {
+      return std::nullopt;
+    }
+    if (entry->compression != Compression::Stored) {
+      throw std::runtime_error(fmt::format(
+          "unsupported compression {0} for {1} in archive {2}",
+          static_cast<std::uint32_t>(entry->compression), entry->name,
+          m_path.string()));
+    }
+    return m_file.slice(static_cast<std::size_t>(entry->dataOffset),
+                        static_cast<std::size_t>(entry->storedSize));
+  }
+
+  static void pack(const std::filesystem::path &directory,
+                   const std::filesystem::path &archivePath) {
+    struct Source {
+      std::string name;
+      std::filesystem::path path;
+      std::uint64_t size;
+    };
+    auto sources = std::vector<Source>();
+    for (const auto &dirEntry :
+         std::filesystem::recursive_directory_iterator(directory)) {
+      if (dirEntry.is_regular_file()) {
+        sources.push_back(
+            {entryName(std::filesystem::relative(dirEntry.path(), directory)),
+             dirEntry.path(), dirEntry.file_size()});
+      }
+    }
+    std::sort(sources.begin(), sources.end(),
+              [](const auto &a, const auto &b) { return a.name < b.name; });
+
+    const auto align = [](const std::uint64_t offset) {
+      return (offset + ENTRY_ALIGNMENT - 1) / ENTRY_ALIGNMENT * ENTRY_ALIGNMENT;
+    };
+    const auto namesOffset =
+        std::uint64_t{HEADER_SIZE + ENTRY_SIZE * sources.size()};
+    auto namesSize = std::uint64_t{0};
+    for (const auto &source : sources) {
+      namesSize += source.name.size();
+    }
+
+    auto output = std::ofstream(archivePath, std::ios_base::binary);
+    output.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+    output.write(MAGIC.data(), MAGIC.size());
+    writeLittleEndian(output, VERSION);
+    writeLittleEndian(output, static_cast<std::uint32_t>(sources.size()));
+    writeLittleEndian(output, namesOffset);
+    writeLittleEndian(output, namesSize);
+
+    auto nameOffset = std::uint64_t{0};
+    auto dataOffset = align(namesOffset + namesSize);
+    for (const auto &source : sources) {
+      writeLittleEndian(output, nameOffset);
+      writeLittleEndian(output, static_cast<std::uint32_t>(source.name.size()));
+      writeLittleEndian(output,
+                        static_cast<std::uint32_t>(Compression::Stored));
+      writeLittleEndian(output, dataOffset);
+      writeLittleEndian(output, source.size);
+      writeLittleEndian(output, source.size);
+      nameOffset += source.name.size();
+      dataOffset = align(dataOffset + source.size);
+    }
+    for (const auto &source : sources) {
+      output.write(source.name.data(),
+                   static_cast<std::streamsize>(source.name.size()));
+    }
+
+    auto buffer = std::vector<char>();
+    for (const auto &source : sources) {
+      const auto padding = align(static_cast<std::uint64_t>(output.tellp())) -
+                           static_cast<std::uint64_t>(output.tellp());
+      buffer.assign(static_cast<std::size_t>(padding), '\0');
+      output.write(buffer.data(), static_cast<std::streamsize>(padding));
+
+      auto input = std::ifstream(source.path, std::ios_base::binary);
+      input.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+      buffer.resize(static_cast<std::size_t>(source.size));
+      input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+  }
+};
+
+Archive::Archive(const std::filesystem::path &path)
+    : m_pImpl(std::make_unique<Impl>(path)) {}
+
+Archive::~Archive() noexcept = default;
+
+Archive::Archive(Archive &&other) noexcept = default;
+Archive &Archive::operator=(Archive &&other) noexcept = default;
+
+std::size_t Archive::nEntries() const noexcept { return m_pImpl->nEntries(); }
+
+bool Archive::contains(const std::filesystem::path &path) const {
+  return m_pImpl->contains(path);
+}
+
+std::optional<MappedFile>
+Archive::find(const std::filesystem::path &path) const {
+  return m_pImpl->find(path);
+}
+
+void Archive::pack(const std::filesystem::path &directory,
+                   const std::filesystem::path &archivePath) {
+  Impl::pack(directory, archivePath);
+}
+
+} // namespace platform
+} // namespace mata
@@ -0,0 +1,180 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include <mata/core/types.hpp>
+
+#include "mata/platform/mapped_file.hpp"
+#include "mata/platform/platform.hpp"
+
+#if MATA_OS_WINDOWS
+#include <Windows.h>
+#elif MATA_OS_MACOS || MATA_OS_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#error "Unknown platform is unsupported"
+#endif
+
+namespace mata {
+namespace platform {
+
+class MappedFile::Mapping final {
+  const mata::core::byte *m_pData = nullptr;
+  std::size_t m_size = 0;
+#if MATA_OS_WINDOWS
+  HANDLE m_hFile = INVALID_HANDLE_VALUE;
+  HANDLE m_hMapping = nullptr;
+#else
+  int m_fd = -1;
+#endif
+
+public:
+  Mapping(const std::filesystem::path &path) {
+#if MATA_OS_WINDOWS
+    m_hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_hFile == INVALID_HANDLE_VALUE) {
+      throw std::runtime_error(
+          fmt::format("failed to open file: {0}", path.string()));
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_hFile, &size)) {
+      CloseHandle(m_hFile);
+      throw std::runtime_error(
+          fmt::format("failed to get file size: {0}", path.string()));
+    }
+    m_size = static_cast<std::size_t>(size.QuadPart);
+    // Empty files can't be mapped, but they're valid files.
+    if (m_size == 0) {
+      return;
+    }
+    m_hMapping =
+        CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_hMapping == nullptr) {
+      CloseHandle(m_hFile);
+      throw std::runtime_error(
+          fmt::format("failed to map file: {0}", path.string()));
+    }
+    m_pData = static_cast<const mata::core::byte *>(
+        MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_pData == nullptr) {
+      CloseHandle(m_hMapping);
+      CloseHandle(m_hFile);
+      throw std::runtime_error(
+          fmt::format("failed to map file: {0}", path.string()));
+    }
+#else
+    m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd == -1) {
+      throw std::runtime_error(
+          fmt::format("failed to open file: {0}", path.string()));
+    }
+    struct stat status;
+    if (fstat(m_fd, &status) == -1) {
+      close(m_fd);
+      throw std::runtime_error(
+          fmt::format("failed to get file size: {0}", path.string()));
+    }
+    m_size = static_cast<std::size_t>(status.st_size);
+    // Empty files can't be mapped, but they're valid files.
+    if (m_size == 0) {
+      return;
+    }
+    auto pData = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (pData == MAP_FAILED) {
+      close(m_fd);
+      throw std::runtime_error(
+          fmt::format("failed to map file: {0}", path.string()));
+    }
+    m_pData = static_cast<const mata::core::byte *>(pData);
+#endif
+  }
+
+  ~Mapping() {
+#if MATA_OS_WINDOWS
+    if (m_pData != nullptr) {
+      UnmapViewOfFile(m_pData);
+    }
+    if (m_hMapping != nullptr) {
+      CloseHandle(m_hMapping);
+    }
+    CloseHandle(m_hFile);
+#else
+    if (m_pData != nullptr) {
+      munmap(const_cast<mata::core::byte *>(m_pData), m_size);
+    }
+    close(m_fd);
+#endif
+  }
+
+  Mapping(const Mapping &) = delete;
+  Mapping &operator=(const Mapping &) = delete;
+
+  mata::core::bytes_view bytes() const noexcept { return {m_pData, m_size}; }
+};
+
+class MappedFile::Impl final {
+  std::shared_ptr<const Mapping> m_pMapping;
+  mata::core::bytes_view m_bytes;
+
+public:
+  Impl(const std::filesystem::path &path)
+      : m_pMapping(std::make_shared<const Mapping>(path)),
+        m_bytes(m_pMapping->bytes()) {}
+
+  Impl(const std::shared_ptr<const Mapping> pMapping,
+       const mata::core::bytes_view bytes) noexcept
+      : m_pMapping(pMapping), m_bytes(bytes) {}
+
+  mata::core::bytes_view bytes() const noexcept { return m_bytes; }
+
+  std::size_t size() const noexcept { return m_bytes.size(); }
+
+  std::unique_ptr<Impl> slice(const std::size_t offset,
+                              const std::size_t size) const {
+    if (offset > m_bytes.size() || size > m_bytes.size() - offset) {
+      throw std::out_of_range(
+          fmt::format("slice [{0}, {1}) is outside of mapping of size {2}",
+                      offset, offset + size, m_bytes.size()));
+    }
+    return std::make_unique<Impl>(
+        m_pMapping,
+        mata::core::bytes_view(m_bytes.data() + offset, size));
+  }
+};
+
+MappedFile::MappedFile(const std::filesystem::path &path)
+    : m_pImpl(std::make_unique<Impl>(path)) {}
+
+MappedFile::MappedFile(std::unique_ptr<Impl> pImpl) noexcept
+    : m_pImpl(std::move(pImpl)) {}
+
+MappedFile::~MappedFile() noexcept = default;
+
+MappedFile::MappedFile(MappedFile &&other) noexcept = default;
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept = default;
+
+mata::core::bytes_view MappedFile::bytes() const noexcept {
+  return m_pImpl->bytes();
+}
+
+std::size_t MappedFile::size() const noexcept { return m_pImpl->size(); }
+
+MappedFile MappedFile::slice(const std::size_t offset,
+                             const std::size_t size) const {
+  return MappedFile(m_pImpl->slice(offset, size));
+}
+
+} // namespace platform
+} // namespace mata
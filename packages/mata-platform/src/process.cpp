@@ -0,0 +1,47 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <cstddef>
+#include <stdexcept>
+
+#include "mata/platform/platform.hpp"
+#include "mata/platform/process.hpp"
+
+#if MATA_OS_WINDOWS
+#include <Windows.h>
+// Must follow Windows.h.
+#include <Psapi.h>
+#elif MATA_OS_MACOS || MATA_OS_LINUX
+#include <sys/resource.h>
+#else
+#error "Unknown platform is unsupported"
+#endif
+
+namespace mata {
+namespace platform {
+
+std::size_t peakResidentSetSize() {
+#if MATA_OS_WINDOWS
+  auto counters = PROCESS_MEMORY_COUNTERS{};
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                            sizeof(counters))) {
+    throw std::runtime_error("failed to read process memory counters");
+  }
+  return counters.PeakWorkingSetSize;
+#else
+  auto usage = rusage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    throw std::runtime_error("failed to read process resource usage");
+  }
+#if MATA_OS_MACOS
+  // macOS reports bytes where Linux reports kilobytes.
+  return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+  return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+} // namespace platform
+} // namespace mata
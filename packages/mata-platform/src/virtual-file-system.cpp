@@ -2,26 +2,42 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <cstddef>
 #include <exception>
 #include <filesystem>
 #include <fstream>
-#include <iterator>
+#include <ios>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <fmt/format.h>
 
 #include <mata/core/types.hpp>
 
+#include "mata/platform/archive.hpp"
+#include "mata/platform/mapped_file.hpp"
 #include "mata/platform/virtual_file_system.hpp"
 
 namespace mata {
 namespace platform {
 
-class [[nodiscard]] VirtualFileSystem::Impl final {
+namespace {
+
+// A directory of loose files or an archive that files are looked up in.
+class Mount final {
   std::filesystem::path m_rootPath;
+  // Set when the root is an archive rather than a directory of loose files.
+  std::optional<Archive> m_archive{};
 
 public:
-  Impl(const std::filesystem::path &rootPath) : m_rootPath(rootPath) {
+  explicit Mount(const std::filesystem::path &rootPath)
+      : m_rootPath(rootPath) {
     if (!rootPath.is_absolute()) {
       throw std::logic_error(
           fmt::format("root path is not absolute: {0}", rootPath.string()));
@@ -30,39 +46,176 @@ public:
       throw std::runtime_error(
           fmt::format("root path does not exist: {0}", rootPath.string()));
     }
-    if (!std::filesystem::is_directory(rootPath)) {
+    if (std::filesystem::is_regular_file(rootPath)) {
+      m_archive.emplace(rootPath);
+    } else if (!std::filesystem::is_directory(rootPath)) {
       throw std::runtime_error(
-          fmt::format("root path is not a directory: {0}", rootPath.string()));
+          fmt::format("root path is not a directory or archive: {0}",
+                      rootPath.string()));
     }
   }
 
-  [[nodiscard]] mata::core::bytes readFile(const std::filesystem::path &path)
-      const {
-    if (!path.is_relative()) {
-      throw std::logic_error(
-          fmt::format("path must be relative: {0}", path.string()));
+  [[nodiscard]] bool contains(const std::filesystem::path &path) const {
+    if (m_archive) {
+      return m_archive->contains(path);
     }
-    const auto rootedPath = this->m_rootPath / path;
-    if (!std::filesystem::exists(rootedPath)) {
-      throw std::runtime_error(
-          fmt::format("file not found in VFS: {0}", path.string()));
+    return std::filesystem::exists(m_rootPath / path);
+  }
+
+  // Read the whole file with a single read into a buffer of its size.
+  template <typename Buffer>
+  [[nodiscard]] Buffer read(const std::filesystem::path &path) const {
+    if (m_archive) {
+      const auto bytes = this->map(path).bytes();
+      return Buffer(bytes.begin(), bytes.end());
     }
 
+    const auto rootedPath = m_rootPath / path;
     auto inputFile = std::ifstream(rootedPath, std::ios_base::binary);
-    inputFile.exceptions(std::ios_base::badbit);
+    inputFile.exceptions(std::ios_base::badbit | std::ios_base::failbit);
 
+    auto buffer = Buffer(std::filesystem::file_size(rootedPath), '\0');
     // NOTE: we implicly convert between char and unsigned char. This *should*
     // be safe because negative bytes from ifstream seems unlikely or
     // impossible.
-    auto bufferIter = std::istreambuf_iterator<char>(inputFile);
-    const auto bufferIterEnd = std::istreambuf_iterator<char>();
-    return mata::core::bytes(bufferIter, bufferIterEnd);
+    inputFile.read(reinterpret_cast<char *>(buffer.data()),
+                   static_cast<std::streamsize>(buffer.size()));
+    return buffer;
+  }
+
+  [[nodiscard]] MappedFile map(const std::filesystem::path &path) const {
+    if (m_archive) {
+      return std::move(*m_archive->find(path));
+    }
+    return MappedFile(m_rootPath / path);
+  }
+};
+
+} // namespace
+
+class [[nodiscard]] VirtualFileSystem::Impl final {
+  // Searched from the back, so that later mounts take priority.
+  std::vector<Mount> m_mounts{};
+
+  struct CacheEntry {
+    std::string key;
+    std::shared_ptr<const mata::core::bytes> pBytes;
+  };
+  // Caching doesn't change the files read, so it happens through const
+  // methods. Most recently used first.
+  mutable std::list<CacheEntry> m_cache{};
+  mutable std::unordered_map<std::string, std::list<CacheEntry>::iterator>
+      m_cacheIndex{};
+  mutable CacheStats m_cacheStats{};
+  mutable std::mutex m_cacheMutex{};
+  std::size_t m_cacheCapacity = DEFAULT_CACHE_CAPACITY;
+
+  static void checkRelative(const std::filesystem::path &path) {
+    if (!path.is_relative()) {
+      throw std::logic_error(
+          fmt::format("path must be relative: {0}", path.string()));
+    }
+  }
+
+  const Mount &findMount(const std::filesystem::path &path) const {
+    checkRelative(path);
+    for (auto iter = m_mounts.rbegin(); iter != m_mounts.rend(); iter++) {
+      if (iter->contains(path)) {
+        return *iter;
+      }
+    }
+    throw std::runtime_error(
+        fmt::format("file not found in VFS: {0}", path.string()));
+  }
+
+  // Drop least recently used entries until the cache fits in its capacity.
+  // Buffers still held elsewhere stay alive until they're released.
+  void evictToCapacity() const {
+    while (m_cacheStats.nBytes > m_cacheCapacity) {
+      const auto &entry = m_cache.back();
+      m_cacheStats.nBytes -= entry.pBytes->size();
+      m_cacheStats.nEvictions++;
+      m_cacheIndex.erase(entry.key);
+      m_cache.pop_back();
+    }
+  }
+
+public:
+  Impl(const std::filesystem::path &rootPath) { this->mount(rootPath); }
+
+  void mount(const std::filesystem::path &rootPath) {
+    m_mounts.emplace_back(rootPath);
+    // Mounting can shadow files that are already cached.
+    this->clearCache();
+  }
+
+  [[nodiscard]] mata::core::bytes readFile(const std::filesystem::path &path)
+      const {
+    return this->findMount(path).read<mata::core::bytes>(path);
   }
 
   [[nodiscard]] std::string readTextFile(const std::filesystem::path &path)
       const {
-    const auto bytes = this->readFile(path);
-    return std::string(bytes.begin(), bytes.end());
+    return this->findMount(path).read<std::string>(path);
+  }
+
+  [[nodiscard]] MappedFile mapFile(const std::filesystem::path &path) const {
+    return this->findMount(path).map(path);
+  }
+
+  [[nodiscard]] std::shared_ptr<const mata::core::bytes>
+  readSharedFile(const std::filesystem::path &path) const {
+    const auto key = path.lexically_normal().generic_string();
+    auto cacheCapacity = std::size_t{0};
+    {
+      const auto lock = std::lock_guard<std::mutex>(m_cacheMutex);
+      cacheCapacity = m_cacheCapacity;
+      const auto found = m_cacheIndex.find(key);
+      if (found != m_cacheIndex.end()) {
+        m_cacheStats.nHits++;
+        m_cache.splice(m_cache.begin(), m_cache, found->second);
+        return found->second->pBytes;
+      }
+      m_cacheStats.nMisses++;
+    }
+
+    // Read without holding the lock so that other files can be looked up in
+    // the meantime. Two threads missing on the same file both read it, and
+    // the first to finish is cached.
+    auto pBytes =
+        std::make_shared<const mata::core::bytes>(this->readFile(path));
+    if (pBytes->size() > cacheCapacity) {
+      return pBytes;
+    }
+
+    const auto lock = std::lock_guard<std::mutex>(m_cacheMutex);
+    const auto found = m_cacheIndex.find(key);
+    if (found != m_cacheIndex.end()) {
+      return found->second->pBytes;
+    }
+    m_cache.push_front({key, pBytes});
+    m_cacheIndex.emplace(key, m_cache.begin());
+    m_cacheStats.nBytes += pBytes->size();
+    this->evictToCapacity();
+    return pBytes;
+  }
+
+  void setCacheCapacity(const std::size_t nBytes) {
+    const auto lock = std::lock_guard<std::mutex>(m_cacheMutex);
+    m_cacheCapacity = nBytes;
+    this->evictToCapacity();
+  }
+
+  void clearCache() {
+    const auto lock = std::lock_guard<std::mutex>(m_cacheMutex);
+    m_cache.clear();
+    m_cacheIndex.clear();
+    m_cacheStats.nBytes = 0;
+  }
+
+  CacheStats cacheStats() const {
+    const auto lock = std::lock_guard<std::mutex>(m_cacheMutex);
+    return m_cacheStats;
   }
 };
 
@@ -71,6 +224,10 @@ VirtualFileSystem::VirtualFileSystem(const std::filesystem::path &rootPath)
 
 VirtualFileSystem::~VirtualFileSystem() noexcept = default;
 
+void VirtualFileSystem::mount(const std::filesystem::path &rootPath) {
+  m_pImpl->mount(rootPath);
+}
+
 mata::core::bytes
 VirtualFileSystem::readFile(const std::filesystem::path &path) const {
   return m_pImpl->readFile(path);
@@ -81,5 +238,24 @@ VirtualFileSystem::readTextFile(const std::filesystem::path &path) const {
   return m_pImpl->readTextFile(path);
 }
 
+MappedFile VirtualFileSystem::mapFile(const std::filesystem::path &path) const {
+  return m_pImpl->mapFile(path);
+}
+
+std::shared_ptr<const mata::core::bytes>
+VirtualFileSystem::readSharedFile(const std::filesystem::path &path) const {
+  return m_pImpl->readSharedFile(path);
+}
+
+void VirtualFileSystem::setCacheCapacity(const std::size_t nBytes) {
+  m_pImpl->setCacheCapacity(nBytes);
+}
+
+void VirtualFileSystem::clearCache() { m_pImpl->clearCache(); }
+
+VirtualFileSystem::CacheStats VirtualFileSystem::cacheStats() const {
+  return m_pImpl->cacheStats();
+}
+
 } // namespace platform
 } // namespace mata
@@ -0,0 +1,135 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mata/core/little_endian.hpp>
+#include <mata/core/types.hpp>
+#include <mata/platform/archive.hpp>
+#include <mata/platform/mapped_file.hpp>
+#include <mata/platform/virtual_file_system.hpp>
+
+#include "temp_directory.hpp"
+
+namespace {
+
+using mata::platform::Archive;
+
+// Offsets into the layout documented in archive.hpp.
+constexpr std::size_t HEADER_SIZE = 32;
+constexpr std::size_t ENTRY_SIZE = 40;
+constexpr std::size_t ENTRY_DATA_OFFSET = 16;
+
+const auto FILES = std::vector<std::pair<std::string, std::string>>{
+    {"a.txt", "first"},
+    {"b/c.bin", std::string("\0\1\2\3\xff", 5)},
+    {"b/d.txt", std::string(1000, 'd')},
+    {"e.txt", "last"},
+};
+
+std::string toString(const mata::core::bytes_view bytes) {
+  return std::string(bytes.begin(), bytes.end());
+}
+
+// Pack FILES into an archive and return its path.
+std::filesystem::path packFiles(const mata::tests::TempDirectory &directory) {
+  for (const auto &[path, contents] : FILES) {
+    directory.writeFile(std::filesystem::path("files") / path, contents);
+  }
+  const auto archivePath = directory.path() / "files.pak";
+  Archive::pack(directory.path() / "files", archivePath);
+  return archivePath;
+}
+
+// Pack FILES, then write the archive out again after corrupting its bytes.
+template <typename F>
+std::filesystem::path
+packCorruptFiles(const mata::tests::TempDirectory &directory, F &&corrupt) {
+  const auto archivePath = packFiles(directory);
+  auto bytes = [&archivePath]() {
+    const auto file = mata::platform::MappedFile(archivePath);
+    return mata::core::bytes(file.bytes().begin(), file.bytes().end());
+  }();
+  corrupt(bytes);
+  directory.writeFile("files.pak", toString(bytes));
+  return archivePath;
+}
+
+} // namespace
+
+TEST_CASE("Archives read back every packed file", "[archive]") {
+  const auto directory = mata::tests::TempDirectory("mata-archive-test");
+  const auto archivePath = packFiles(directory);
+
+  const auto archive = Archive(archivePath);
+  REQUIRE(archive.nEntries() == FILES.size());
+  for (const auto &[path, contents] : FILES) {
+    const auto file = archive.find(path);
+    REQUIRE(file);
+    REQUIRE(toString(file->bytes()) == contents);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(file->bytes().data()) %
+                Archive::ENTRY_ALIGNMENT ==
+            0);
+  }
+  REQUIRE_FALSE(archive.contains("b"));
+  REQUIRE_FALSE(archive.find("missing.txt"));
+
+  const auto vfs = mata::platform::VirtualFileSystem(archivePath);
+  for (const auto &[path, contents] : FILES) {
+    REQUIRE(vfs.readTextFile(path) == contents);
+    REQUIRE(toString(vfs.mapFile(path).bytes()) == contents);
+  }
+  REQUIRE_THROWS_AS(vfs.readFile("missing.txt"), std::runtime_error);
+}
+
+TEST_CASE("Corrupt archives are rejected", "[archive]") {
+  const auto directory = mata::tests::TempDirectory("mata-archive-test");
+
+  SECTION("truncated header") {
+    const auto archivePath = packCorruptFiles(
+        directory, [](mata::core::bytes &bytes) { bytes.resize(20); });
+    REQUIRE_THROWS_AS(Archive(archivePath), std::runtime_error);
+  }
+
+  SECTION("truncated table of contents") {
+    const auto archivePath =
+        packCorruptFiles(directory, [](mata::core::bytes &bytes) {
+          bytes.resize(HEADER_SIZE + ENTRY_SIZE);
+        });
+    REQUIRE_THROWS_AS(Archive(archivePath), std::runtime_error);
+  }
+
+  SECTION("truncated data") {
+    const auto archivePath = packCorruptFiles(
+        directory, [](mata::core::bytes &bytes) { bytes.pop_back(); });
+    REQUIRE_THROWS_AS(Archive(archivePath), std::runtime_error);
+  }
+
+  SECTION("unsorted entries") {
+    const auto archivePath =
+        packCorruptFiles(directory, [](mata::core::bytes &bytes) {
+          const auto pFirst = bytes.begin() + HEADER_SIZE;
+          std::swap_ranges(pFirst, pFirst + ENTRY_SIZE, pFirst + ENTRY_SIZE);
+        });
+    REQUIRE_THROWS_AS(Archive(archivePath), std::runtime_error);
+  }
+
+  SECTION("entry out of bounds") {
+    const auto archivePath =
+        packCorruptFiles(directory, [](mata::core::bytes &bytes) {
+          mata::core::writeLittleEndian(
+              bytes.data() + HEADER_SIZE + ENTRY_DATA_OFFSET,
+              static_cast<std::uint64_t>(bytes.size()));
+        });
+    REQUIRE_THROWS_AS(Archive(archivePath), std::runtime_error);
+  }
+}
@@ -0,0 +1,50 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <string>
+#include <system_error>
+
+namespace mata {
+namespace tests {
+
+// A directory under the system's temporary directory, removed again with
+// everything in it when the test ends.
+class TempDirectory final {
+  std::filesystem::path m_path;
+
+public:
+  explicit TempDirectory(const std::string &name)
+      : m_path(std::filesystem::temp_directory_path() / name) {
+    std::filesystem::remove_all(m_path);
+    std::filesystem::create_directories(m_path);
+  }
+  ~TempDirectory() {
+    auto error = std::error_code();
+    std::filesystem::remove_all(m_path, error);
+  }
+
+  TempDirectory(const TempDirectory &) = delete;
+  TempDirectory &operator=(const TempDirectory &) = delete;
+
+  [[nodiscard]] const std::filesystem::path &path() const noexcept {
+    return m_path;
+  }
+
+  // Write a file under the directory, creating its parent directories.
+  void writeFile(const std::filesystem::path &path,
+                 const std::string &contents) const {
+    std::filesystem::create_directories((m_path / path).parent_path());
+    auto file = std::ofstream(m_path / path, std::ios_base::binary);
+    file.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+  }
+};
+
+} // namespace tests
+} // namespace mata
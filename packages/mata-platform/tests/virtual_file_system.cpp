@@ -0,0 +1,96 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <string>
+
+#include <mata/core/types.hpp>
+#include <mata/platform/virtual_file_system.hpp>
+
+#include "temp_directory.hpp"
+
+TEST_CASE("Later mounts override earlier ones", "[vfs]") {
+  const auto directory = mata::tests::TempDirectory("mata-vfs-test");
+  directory.writeFile("base/shared.txt", "base");
+  directory.writeFile("base/base.txt", "base only");
+  directory.writeFile("patch/shared.txt", "patch");
+  directory.writeFile("patch/patch.txt", "patch only");
+
+  auto vfs = mata::platform::VirtualFileSystem(directory.path() / "base");
+  REQUIRE(vfs.readTextFile("shared.txt") == "base");
+  // Cached before the patch is mounted, so mounting must drop it.
+  REQUIRE(*vfs.readSharedFile("shared.txt") ==
+          mata::core::bytes{'b', 'a', 's', 'e'});
+
+  vfs.mount(directory.path() / "patch");
+  REQUIRE(vfs.readTextFile("shared.txt") == "patch");
+  REQUIRE(*vfs.readSharedFile("shared.txt") ==
+          mata::core::bytes{'p', 'a', 't', 'c', 'h'});
+  REQUIRE(vfs.readTextFile("base.txt") == "base only");
+  REQUIRE(vfs.readTextFile("patch.txt") == "patch only");
+}
+
+TEST_CASE("Shared file cache", "[vfs]") {
+  const auto directory = mata::tests::TempDirectory("mata-vfs-test");
+  directory.writeFile("a", std::string(100, 'a'));
+  directory.writeFile("b", std::string(100, 'b'));
+  directory.writeFile("c", std::string(100, 'c'));
+  directory.writeFile("large", std::string(1000, 'l'));
+
+  auto vfs = mata::platform::VirtualFileSystem(directory.path());
+  vfs.setCacheCapacity(250);
+
+  const auto pA = vfs.readSharedFile("a");
+  REQUIRE(vfs.readSharedFile("a") == pA);
+  static_cast<void>(vfs.readSharedFile("b"));
+  auto stats = vfs.cacheStats();
+  REQUIRE(stats.nHits == 1);
+  REQUIRE(stats.nMisses == 2);
+  REQUIRE(stats.nEvictions == 0);
+  REQUIRE(stats.nBytes == 200);
+
+  SECTION("least recently used files are evicted first") {
+    // Using a makes b the least recently used.
+    static_cast<void>(vfs.readSharedFile("a"));
+    static_cast<void>(vfs.readSharedFile("c"));
+    stats = vfs.cacheStats();
+    REQUIRE(stats.nEvictions == 1);
+    REQUIRE(stats.nBytes == 200);
+
+    REQUIRE(vfs.readSharedFile("a") == pA);
+    REQUIRE(vfs.cacheStats().nHits == 3);
+    static_cast<void>(vfs.readSharedFile("b"));
+    stats = vfs.cacheStats();
+    REQUIRE(stats.nMisses == 4);
+    // c was used less recently than a.
+    REQUIRE(stats.nEvictions == 2);
+    REQUIRE(vfs.readSharedFile("a") == pA);
+  }
+
+  SECTION("files larger than the cache aren't cached") {
+    static_cast<void>(vfs.readSharedFile("large"));
+    static_cast<void>(vfs.readSharedFile("large"));
+    stats = vfs.cacheStats();
+    REQUIRE(stats.nMisses == 4);
+    REQUIRE(stats.nEvictions == 0);
+    REQUIRE(stats.nBytes == 200);
+  }
+
+  SECTION("shrinking the cache evicts down to its new capacity") {
+    vfs.setCacheCapacity(100);
+    stats = vfs.cacheStats();
+    REQUIRE(stats.nEvictions == 1);
+    REQUIRE(stats.nBytes == 100);
+    // a was evicted, but its buffer lives on with its readers.
+    REQUIRE(*pA == mata::core::bytes(100, 'a'));
+    REQUIRE(vfs.readSharedFile("a") != pA);
+  }
+
+  SECTION("clearing the cache drops every file") {
+    vfs.clearCache();
+    REQUIRE(vfs.cacheStats().nBytes == 0);
+    REQUIRE(vfs.readSharedFile("a") != pA);
+    REQUIRE(vfs.cacheStats().nMisses == 3);
+  }
+}
@@ -0,0 +1,39 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+
+#include <fmt/core.h>
+
+#include <mata/renderer/camera.hpp>
+#include <mata/renderer/texture.hpp>
+#include <mata/renderer/tile_layer.hpp>
+#include <mata/renderer/tileset.hpp>
+
+#include "fixtures.hpp"
+
+// What the pImpl classes' copy constructors cost, since they're passed and
+// stored by value.
+TEST_CASE("pImpl copies", "[copies][!benchmark]") {
+  for (const auto size : {256, 2048}) {
+    const auto tileset = mata::benchmarks::makeTileset(size, 16);
+    const auto &texture = tileset.texture();
+    const auto layerDimensions = mata::core::GridDimensions2d{size, size};
+    const auto layer = mata::renderer::TileLayer(
+        layerDimensions, tileset,
+        mata::benchmarks::randomTiles(layerDimensions, tileset.dimensions()));
+
+    BENCHMARK(fmt::format("Texture {0}x{0}", size)) {
+      return mata::renderer::Texture(texture).dimensions().nColumns;
+    };
+    BENCHMARK(fmt::format("Tileset {0}x{0}", size)) {
+      return mata::renderer::Tileset(tileset).dimensions().nColumns;
+    };
+    BENCHMARK(fmt::format("TileLayer {0}x{0}", size)) {
+      return mata::renderer::TileLayer(layer).dimensions().nColumns;
+    };
+  }
+  const auto camera = mata::renderer::Camera();
+  BENCHMARK("Camera") { return mata::renderer::Camera(camera).zoom(); };
+}
@@ -0,0 +1,93 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <mata/core/geometry.hpp>
+#include <mata/core/types.hpp>
+#include <mata/renderer/texture.hpp>
+#include <mata/renderer/tile_id.hpp>
+#include <mata/renderer/tile_layer.hpp>
+#include <mata/renderer/tileset.hpp>
+
+namespace mata {
+namespace benchmarks {
+
+// Every benchmark generates its inputs from this seed, so that numbers are
+// comparable from run to run.
+constexpr auto SEED = std::uint32_t{20200601};
+
+constexpr auto N_COLOR_CHANNELS = 4;
+
+// Tilesets made with different seeds get different colours, so that the
+// renderer can't share their textures.
+inline mata::renderer::Tileset makeTileset(const int size, const int tileSize,
+                                           const int seed = 0) {
+  const auto nBytes = static_cast<std::size_t>(size) *
+                      static_cast<std::size_t>(size) * N_COLOR_CHANNELS;
+  auto rgba = mata::core::bytes(nBytes);
+  for (auto i = std::size_t{0}; i < nBytes; i++) {
+    rgba[i] = static_cast<mata::core::byte>(i * 31 + i / 4096 +
+                                            static_cast<std::size_t>(seed));
+  }
+  return mata::renderer::Tileset(
+      {tileSize, tileSize}, {size / tileSize, size / tileSize},
+      mata::renderer::Texture({size, size}, std::move(rgba)));
+}
+
+// Tiles picked at random from a tileset, one per cell of a layer.
+inline std::vector<mata::core::Index2d>
+randomTiles(const mata::core::GridDimensions2d &layerDimensions,
+            const mata::core::GridDimensions2d &tilesetDimensions) {
+  auto random = std::mt19937(SEED);
+  auto column = std::uniform_int_distribution<int>(
+      0, tilesetDimensions.nColumns - 1);
+  auto row =
+      std::uniform_int_distribution<int>(0, tilesetDimensions.nRows - 1);
+  auto tiles = std::vector<mata::core::Index2d>(
+      static_cast<std::size_t>(layerDimensions.nColumns) *
+      static_cast<std::size_t>(layerDimensions.nRows));
+  for (auto &tile : tiles) {
+    tile = {column(random), row(random)};
+  }
+  return tiles;
+}
+
+// Decoration layers hold tiles in blocks of this many cells across.
+constexpr auto DECORATION_BLOCK_SIZE = 32;
+
+// Tiles picked at random in a fraction of a layer's blocks, as in a
+// decoration layer; every other cell is left empty. Blocks are picked by
+// hashing their position, so the same ones are filled whatever the layer's
+// size. Layers made with different seeds get different tiles.
+inline std::vector<mata::renderer::PlacedTile>
+decorationTiles(const mata::core::GridDimensions2d &layerDimensions,
+                const mata::core::GridDimensions2d &tilesetDimensions,
+                const float coverage = 0.1f, const int seed = 0) {
+  auto random = std::mt19937(SEED + static_cast<std::uint32_t>(seed));
+  auto tile = std::uniform_int_distribution<int>(
+      0, tilesetDimensions.nColumns * tilesetDimensions.nRows - 1);
+  auto tiles = std::vector<mata::renderer::PlacedTile>{};
+  for (auto j = 0; j < layerDimensions.nRows; j++) {
+    for (auto i = 0; i < layerDimensions.nColumns; i++) {
+      const auto hash =
+          (static_cast<std::uint32_t>(i / DECORATION_BLOCK_SIZE) *
+           73856093u) ^
+          (static_cast<std::uint32_t>(j / DECORATION_BLOCK_SIZE) * 19349663u);
+      if (static_cast<float>(hash % 1000u) < coverage * 1000.0f) {
+        tiles.push_back({{i, j}, mata::renderer::TileId(tile(random))});
+      }
+    }
+  }
+  return tiles;
+}
+
+} // namespace benchmarks
+} // namespace mata
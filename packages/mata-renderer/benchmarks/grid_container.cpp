@@ -0,0 +1,107 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <mata/core/geometry.hpp>
+
+#include "fixtures.hpp"
+
+namespace {
+
+template <typename Layout>
+void benchmarkGridContainer(const std::string &layoutName) {
+  for (const auto size : {64, 1024}) {
+    const auto dimensions = mata::core::GridDimensions2d{size, size};
+    auto grid = mata::core::GridContainer<mata::core::Index2d, Layout>(
+        dimensions, mata::benchmarks::randomTiles(dimensions, {16, 16}));
+    // Random indices, the same every run, measure access without the cache
+    // friendly order of a sweep.
+    auto random = std::mt19937(mata::benchmarks::SEED);
+    auto coordinate = std::uniform_int_distribution<int>(0, size - 1);
+    auto indices = std::vector<mata::core::Index2d>(4096);
+    for (auto &index : indices) {
+      index = {coordinate(random), coordinate(random)};
+    }
+
+    BENCHMARK(fmt::format("{0} at row by row {1}x{1}", layoutName, size)) {
+      auto sum = 0;
+      for (auto j = 0; j < size; j++) {
+        for (auto i = 0; i < size; i++) {
+          sum += grid.at({i, j}).i;
+        }
+      }
+      return sum;
+    };
+    BENCHMARK(fmt::format("{0} [] row by row {1}x{1}", layoutName, size)) {
+      auto sum = 0;
+      for (auto j = 0; j < size; j++) {
+        for (auto i = 0; i < size; i++) {
+          sum += grid[{i, j}].i;
+        }
+      }
+      return sum;
+    };
+    BENCHMARK(fmt::format("{0} at random {1}x{1}", layoutName, size)) {
+      auto sum = 0;
+      for (const auto &index : indices) {
+        sum += grid.at(index).i;
+      }
+      return sum;
+    };
+    // The access pattern of building a tile layer's meshes.
+    BENCHMARK(fmt::format("{0} chunk by chunk {1}x{1}", layoutName, size)) {
+      auto sum = 0;
+      grid.forEachChunk({32, 32}, [&](const mata::core::Index2d &origin,
+                                      const mata::core::GridDimensions2d
+                                          &chunkDimensions) {
+        grid.forEachIn(origin, chunkDimensions,
+                       [&](const mata::core::Index2d &,
+                           const mata::core::Index2d &element) {
+                         sum += element.i;
+                       });
+      });
+      return sum;
+    };
+    // A 3x3 neighbourhood around random cells, as in autotiling.
+    BENCHMARK(fmt::format("{0} neighbours random {1}x{1}", layoutName, size)) {
+      auto sum = 0;
+      for (const auto &index : indices) {
+        grid.forEachIn({index.i - 1, index.j - 1}, {3, 3},
+                       [&](const mata::core::Index2d &,
+                           const mata::core::Index2d &element) {
+                         sum += element.i;
+                       });
+      }
+      return sum;
+    };
+    BENCHMARK(fmt::format("{0} set row by row {1}x{1}", layoutName, size)) {
+      for (auto j = 0; j < size; j++) {
+        for (auto i = 0; i < size; i++) {
+          grid.set({i, j}, {j, i});
+        }
+      }
+      return grid.at({0, 0}).i;
+    };
+    BENCHMARK(fmt::format("{0} set random {1}x{1}", layoutName, size)) {
+      for (const auto &index : indices) {
+        grid.set(index, index);
+      }
+      return grid.at({0, 0}).i;
+    };
+  }
+}
+
+} // namespace
+
+TEST_CASE("Grid container", "[grid_container][!benchmark]") {
+  benchmarkGridContainer<mata::core::RowMajorLayout>("row major");
+  benchmarkGridContainer<mata::core::TiledLayout<32>>("tiled");
+  benchmarkGridContainer<mata::core::MortonLayout>("morton");
+}
@@ -0,0 +1,55 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/core.h>
+#include <lodepng.h>
+
+#include <mata/core/types.hpp>
+#include <mata/renderer/texture.hpp>
+
+#include "fixtures.hpp"
+
+namespace {
+
+// Smooth gradients with some noise, which compress more like real tilesets
+// than pure noise does.
+std::vector<unsigned char> makePng(const unsigned int size) {
+  auto random = std::mt19937(mata::benchmarks::SEED);
+  auto noise = std::uniform_int_distribution<unsigned int>(0, 15);
+  auto rgba = std::vector<unsigned char>(size * size * 4);
+  for (auto y = 0u; y < size; y++) {
+    for (auto x = 0u; x < size; x++) {
+      auto *pPixel = &rgba[(y * size + x) * 4];
+      pPixel[0] = static_cast<unsigned char>((x + noise(random)) & 0xff);
+      pPixel[1] = static_cast<unsigned char>((y + noise(random)) & 0xff);
+      pPixel[2] = static_cast<unsigned char>(((x ^ y) >> 2) & 0xff);
+      pPixel[3] = 0xff;
+    }
+  }
+  auto png = std::vector<unsigned char>{};
+  if (lodepng::encode(png, rgba, size, size) != 0) {
+    throw std::runtime_error("failed to encode benchmark PNG");
+  }
+  return png;
+}
+
+} // namespace
+
+TEST_CASE("Texture from PNG", "[texture][!benchmark]") {
+  for (const auto size : {256u, 1024u, 2048u}) {
+    const auto png = makePng(size);
+    const auto bytes = mata::core::bytes_view(
+        reinterpret_cast<const mata::core::byte *>(png.data()), png.size());
+
+    BENCHMARK(fmt::format("decode {0}x{0}", size)) {
+      return mata::renderer::Texture::fromPng(bytes).dimensions().nColumns;
+    };
+  }
+}
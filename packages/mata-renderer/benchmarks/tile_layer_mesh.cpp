@@ -0,0 +1,41 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+
+#include <fmt/core.h>
+
+#include <mata/renderer/tile_layer.hpp>
+
+#include "fixtures.hpp"
+#include "tile_layer_mesh.hpp"
+
+TEST_CASE("Tile layer mesh", "[tile_layer_mesh][!benchmark]") {
+  const auto tileset = mata::benchmarks::makeTileset(256, 16);
+  for (const auto size : {64, 512, 2048}) {
+    const auto dimensions = mata::core::GridDimensions2d{size, size};
+    const auto layer = mata::renderer::TileLayer(
+        dimensions, tileset,
+        mata::benchmarks::randomTiles(dimensions, tileset.dimensions()));
+    const auto decoration = mata::benchmarks::decorationTiles(
+        dimensions, tileset.dimensions());
+    const auto denseDecoration =
+        mata::renderer::TileLayer(dimensions, tileset, decoration,
+                                  mata::renderer::TileStorage::Dense);
+    const auto sparseDecoration =
+        mata::renderer::TileLayer(dimensions, tileset, decoration);
+
+    BENCHMARK(fmt::format("build {0}x{0}", size)) {
+      return mata::renderer::TileLayerMesh(layer).instances().size();
+    };
+    BENCHMARK(fmt::format("build decoration {0}x{0}", size)) {
+      return mata::renderer::TileLayerMesh(denseDecoration).instances().size();
+    };
+    BENCHMARK(fmt::format("build sparse decoration {0}x{0}", size)) {
+      return mata::renderer::TileLayerMesh(sparseDecoration)
+          .instances()
+          .size();
+    };
+  }
+}
@@ -0,0 +1,29 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+
+#include <fmt/core.h>
+
+#include <mata/renderer/tileset.hpp>
+
+#include "fixtures.hpp"
+
+TEST_CASE("Tileset linear bytes", "[tileset][!benchmark]") {
+  for (const auto size : {1024, 8192}) {
+    const auto tileset = mata::benchmarks::makeTileset(size, 32);
+
+    BENCHMARK(fmt::format("uncached {0}x{0}", size)) {
+      // Copies share the cached result, so build a new tileset from the
+      // same texture to measure the transposition itself.
+      const auto uncached = mata::renderer::Tileset(
+          tileset.tileSize(), tileset.dimensions(), tileset.texture());
+      return uncached.asLinearBytes().size();
+    };
+    static_cast<void>(tileset.asLinearBytes());
+    BENCHMARK(fmt::format("cached {0}x{0}", size)) {
+      return tileset.asLinearBytes().size();
+    };
+  }
+}
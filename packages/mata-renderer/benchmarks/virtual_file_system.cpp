@@ -0,0 +1,73 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <mata/platform/virtual_file_system.hpp>
+
+#include "fixtures.hpp"
+
+namespace {
+
+// A directory of random files, removed again when the benchmark ends.
+class TempFiles final {
+  std::filesystem::path m_directory;
+
+public:
+  explicit TempFiles(const std::vector<std::size_t> &sizes)
+      : m_directory(std::filesystem::temp_directory_path() /
+                    "mata-vfs-benchmark") {
+    std::filesystem::create_directories(m_directory);
+    auto random = std::mt19937(mata::benchmarks::SEED);
+    for (const auto size : sizes) {
+      auto contents = std::string(size, '\0');
+      for (auto &c : contents) {
+        c = static_cast<char>(random());
+      }
+      auto file = std::ofstream(m_directory / std::to_string(size),
+                                std::ios::binary);
+      file.write(contents.data(), static_cast<std::streamsize>(size));
+    }
+  }
+  ~TempFiles() {
+    auto error = std::error_code();
+    std::filesystem::remove_all(m_directory, error);
+  }
+
+  TempFiles(const TempFiles &) = delete;
+  TempFiles &operator=(const TempFiles &) = delete;
+
+  [[nodiscard]] const std::filesystem::path &directory() const noexcept {
+    return m_directory;
+  }
+};
+
+} // namespace
+
+TEST_CASE("Virtual file system reads", "[vfs][!benchmark]") {
+  const auto sizes = std::vector<std::size_t>{4 * 1024, 1024 * 1024,
+                                              16 * 1024 * 1024};
+  const auto files = TempFiles(sizes);
+  const auto vfs = mata::platform::VirtualFileSystem(files.directory());
+  for (const auto size : sizes) {
+    const auto path = std::to_string(size);
+
+    BENCHMARK(fmt::format("readFile {0} bytes", size)) {
+      return vfs.readFile(path).size();
+    };
+    static_cast<void>(vfs.readSharedFile(path));
+    BENCHMARK(fmt::format("readSharedFile cached {0} bytes", size)) {
+      return vfs.readSharedFile(path)->size();
+    };
+  }
+}
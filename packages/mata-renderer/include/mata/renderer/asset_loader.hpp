@@ -0,0 +1,57 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <optional>
+
+#include <mata/core/geometry.hpp>
+#include <mata/platform/virtual_file_system.hpp>
+#include <mata/utils/propagate_const.hpp>
+
+#include "texture.hpp"
+#include "tileset.hpp"
+
+namespace mata {
+namespace renderer {
+
+// Reads and decodes assets on a pool of worker threads. Nothing here touches
+// OpenGL, so the results are handed to the renderer on the GL thread.
+class AssetLoader final {
+  class Impl;
+  MATA_PROPAGATE_CONST(std::unique_ptr<Impl>) m_pImpl;
+
+public:
+  // Tilesets loaded from PNGs are baked into the cache directory, if one is
+  // given, and mapped from there on later runs. With no thread count given,
+  // one worker is started per hardware thread.
+  explicit AssetLoader(
+      const std::shared_ptr<mata::platform::VirtualFileSystem> pVfs,
+      const std::optional<std::filesystem::path> &tilesetCachePath =
+          std::nullopt,
+      const std::size_t nThreads = 0);
+  ~AssetLoader() noexcept;
+
+  [[nodiscard]] std::future<Texture>
+  loadTexture(const std::filesystem::path &path);
+
+  // Also computes the tileset's linear bytes so that uploading it doesn't
+  // have to.
+  [[nodiscard]] std::future<Tileset>
+  loadTileset(const std::filesystem::path &path,
+              const mata::core::GridDimensions2d tileSize,
+              const mata::core::GridDimensions2d dimensions);
+
+  // Load a tileset baked by mata-texconv, whose tile size and dimensions are
+  // stored in the file.
+  [[nodiscard]] std::future<Tileset>
+  loadBakedTileset(const std::filesystem::path &path);
+};
+
+} // namespace renderer
+} // namespace mata
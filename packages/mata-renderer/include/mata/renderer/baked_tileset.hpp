@@ -0,0 +1,42 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <mata/core/types.hpp>
+#include <mata/platform/mapped_file.hpp>
+
+#include "texture.hpp"
+#include "tileset.hpp"
+
+namespace mata {
+namespace renderer {
+
+// Baked tilesets are stored with their tiles already stacked in the order
+// they're uploaded as array layers, so they can be uploaded straight from the
+// file. The file is a header followed by the layers, either RGBA8 pixels or
+// compressed blocks, with integers stored little endian:
+//
+//   magic "MATATEX\0", u32 version, u32 format, u32 tileWidth,
+//   u32 tileHeight, u32 nColumns, u32 nRows, u64 nBytes, layers
+
+// Encode a tileset's linear bytes, in whatever format its texture is in, as a
+// baked tileset file.
+[[nodiscard]] mata::core::bytes bakeTileset(const Tileset &tileset);
+
+// Compress a tileset's tiles and encode them as a baked tileset file. Throws
+// std::logic_error unless the tiles' sizes are multiples of 4 pixels.
+[[nodiscard]] mata::core::bytes compressTileset(const Tileset &tileset,
+                                                const TextureFormat format);
+
+// Load a baked tileset file, copying its layers. The tileset's texture holds
+// the stacked layers, which Tileset::asLinearBytes returns as they are.
+[[nodiscard]] Tileset loadBakedTileset(const mata::core::bytes_view file);
+
+// Load a mapped baked tileset file without copying it. The tileset's texture
+// keeps the mapping alive and views the layers in place.
+[[nodiscard]] Tileset loadBakedTileset(mata::platform::MappedFile file);
+
+} // namespace renderer
+} // namespace mata
@@ -22,7 +22,19 @@ public:
   explicit Camera();
   ~Camera() noexcept;
 
+  Camera(const Camera &other);
+  Camera &operator=(const Camera &other);
+
+  // The view alpha of the way from previous to current, for drawing between
+  // two simulation steps.
+  [[nodiscard]] static Camera interpolate(const Camera &previous,
+                                          const Camera &current,
+                                          const float alpha);
+
   void translateBy(const glm::vec2 &translation);
+  // Scale the view about the centre of the screen; factors below 1 zoom out.
+  void zoomBy(const float factor);
+  [[nodiscard]] float zoom() const noexcept;
   [[nodiscard]] glm::mat4 viewMatrix() const;
 };
 
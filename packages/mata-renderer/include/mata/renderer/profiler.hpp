@@ -0,0 +1,83 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+#include <mata/utils/propagate_const.hpp>
+
+namespace mata {
+namespace renderer {
+
+using ProfileClock = std::chrono::steady_clock;
+
+// A span of work done on the CPU by one thread, or on the GPU.
+struct ProfileEvent {
+  // Only the pointer is kept, so names have to be string literals.
+  const char *name;
+  // The thread the work ran on, or Profiler::GPU_TRACK.
+  std::uint32_t track;
+  ProfileClock::time_point start;
+  ProfileClock::duration duration;
+};
+
+// Keeps the events of the last few frames in a ring buffer, to be exported
+// as a Chrome trace (chrome://tracing or https://ui.perfetto.dev) when a
+// frame spike needs explaining. Events can be recorded from any thread.
+class Profiler final {
+  class Impl;
+  MATA_PROPAGATE_CONST(std::unique_ptr<Impl>) m_pImpl;
+
+public:
+  static constexpr auto GPU_TRACK = std::uint32_t{0};
+  static constexpr auto DEFAULT_FRAMES_KEPT = std::size_t{600};
+
+  // Times the CPU from construction to destruction. Does nothing without a
+  // profiler, so that scopes can be left in when profiling is off.
+  class Scope final {
+    Profiler *m_pProfiler;
+    const char *m_name;
+    ProfileClock::time_point m_start{};
+
+  public:
+    Scope(Profiler *pProfiler, const char *name) noexcept;
+    ~Scope() noexcept;
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+  };
+
+  explicit Profiler(const std::size_t nFramesKept = DEFAULT_FRAMES_KEPT);
+  ~Profiler() noexcept;
+
+  // The frame events are currently recorded into.
+  [[nodiscard]] std::uint64_t frameNumber() const noexcept;
+
+  void recordCpu(const char *name, const ProfileClock::time_point start,
+                 const ProfileClock::time_point end) noexcept;
+  // GPU timings are read back frames after they were measured, so they name
+  // their frame; they're dropped if it has already left the ring buffer.
+  void recordGpu(const std::uint64_t frameNumber, const char *name,
+                 const ProfileClock::time_point start,
+                 const ProfileClock::duration duration) noexcept;
+
+  // Move on to a new frame, reusing the oldest one kept.
+  void endFrame() noexcept;
+
+  // The events of a frame that's still kept, in the order recorded.
+  [[nodiscard]] std::vector<ProfileEvent>
+  frameEvents(const std::uint64_t frameNumber) const;
+
+  // Write every kept frame in the Trace Event Format's JSON object format.
+  void writeChromeTrace(std::ostream &out) const;
+};
+
+} // namespace renderer
+} // namespace mata
@@ -4,21 +4,62 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 
+#include <mata/core/geometry.hpp>
 #include <mata/platform/virtual_file_system.hpp>
 #include <mata/utils/propagate_const.hpp>
 
 #include "camera.hpp"
+#include "profiler.hpp"
+#include "sprite.hpp"
+#include "tile_id.hpp"
 #include "tile_layer.hpp"
+#include "tileset.hpp"
 #include "window.hpp"
 
 namespace mata {
 namespace renderer {
 
+enum class LayerRenderMode {
+  // Draw every tile as an instance of a quad, culled chunk by chunk.
+  Mesh,
+  // Upload the tile grid as a texture and draw a single screen covering
+  // triangle that looks up the tile under each fragment. This needs no
+  // per-tile vertex data and its draw cost doesn't depend on the layer size.
+  TileMap,
+};
+
+enum class GlErrorCheckMode {
+  // Call glGetError after every GL call. Reports the failing function but
+  // forces a round trip to the driver for every call.
+  PerCall,
+  // Have the driver report errors through a KHR_debug message callback; falls
+  // back to PerFrame when the extension isn't available.
+  DebugOutput,
+  // Call glGetError once at the end of every frame.
+  PerFrame,
+};
+
+struct RendererParams {
+#ifdef NDEBUG
+  GlErrorCheckMode errorCheckMode = GlErrorCheckMode::PerFrame;
+#else
+  GlErrorCheckMode errorCheckMode = GlErrorCheckMode::PerCall;
+#endif
+  // Give tileset textures a full mip chain, so that zoomed out views sample
+  // small levels instead of aliasing over full resolution texels.
+  bool tilesetMipmaps = true;
+  // Record drawFrame's CPU spans and GPU timings with this profiler.
+  std::shared_ptr<Profiler> pProfiler = nullptr;
+};
+
 class Renderer final {
   class Impl;
   MATA_PROPAGATE_CONST(std::unique_ptr<Impl>) m_pImpl;
@@ -26,18 +67,70 @@ class Renderer final {
 public:
   using LayerIdx = unsigned int;
 
+  // Counters describing the last frame drawn by drawFrame.
+  struct FrameStats {
+    unsigned int drawCalls = 0;
+    unsigned int chunksDrawn = 0;
+    unsigned int chunksCulled = 0;
+    // Binds and uniform uploads made, and those skipped because the state
+    // was already current.
+    unsigned int stateChanges = 0;
+    unsigned int stateChangesAvoided = 0;
+    // Bytes written to the stream buffer, and waits for the GPU to finish
+    // reading a region of it before it could be reused.
+    std::size_t bytesStreamed = 0;
+    unsigned int streamStalls = 0;
+    unsigned int spritesDrawn = 0;
+    unsigned int spritesCulled = 0;
+  };
+
   Renderer(const Window &window,
-           const std::shared_ptr<mata::platform::VirtualFileSystem>);
+           const std::shared_ptr<mata::platform::VirtualFileSystem>,
+           const RendererParams &params = RendererParams{});
   ~Renderer() noexcept;
 
-  void setLayer(const LayerIdx layerN, const TileLayer &layer);
+  // Switch to calling GL from this thread, after the window's context has
+  // been made current on it. The renderer must be used from one thread at a
+  // time.
+  void useOnCurrentThread();
+
+  void setLayer(const LayerIdx layerN, const TileLayer &layer,
+                const LayerRenderMode mode = LayerRenderMode::Mesh);
+
+  // Change the tiles of a layer without rebuilding it; edits are uploaded
+  // once per frame by drawFrame.
+  void setTile(const LayerIdx layerN, const mata::core::Index2d &index,
+               const TileId tile);
+  void setTiles(const LayerIdx layerN, const mata::core::Index2d &origin,
+                const mata::core::GridDimensions2d &dimensions,
+                const std::vector<TileId> &tiles);
+
+  // Tileset textures are shared between layers and kept after the last layer
+  // using them is replaced; this deletes those unused textures and returns
+  // how many were deleted.
+  std::size_t evictUnusedTilesets();
+
+  // Queue sprites to be drawn over every tile layer in the next frame only.
+  // Sprites from every call are batched by tileset and depth, so thousands
+  // of them cost a few draw calls.
+  void submitSprites(const Tileset &tileset,
+                     const std::vector<Sprite> &sprites);
 
   void updateCamera(const Camera &camera) noexcept;
 
+  // The time tile animations are evaluated at, from when they all started.
+  void setAnimationTime(const std::chrono::milliseconds time) noexcept;
+
   void toggleWireframeMode();
 
   void drawFrame();
 
+  [[nodiscard]] FrameStats frameStats() const noexcept;
+
+  // The error check mode in use, which differs from the requested one when
+  // the context doesn't support it.
+  [[nodiscard]] GlErrorCheckMode errorCheckMode() const noexcept;
+
   void resize(const int width, const int height);
 };
 
@@ -0,0 +1,34 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <mata/core/geometry.hpp>
+
+namespace mata {
+namespace renderer {
+
+// A tile of a tileset drawn anywhere on top of the tile layers, for things
+// that move around the map.
+struct Sprite {
+  // The top left corner in tile space, where tile (i, j) covers [i, i + 1) x
+  // [j, j + 1).
+  glm::vec2 position = {0.0f, 0.0f};
+  // The size in tiles.
+  glm::vec2 size = {1.0f, 1.0f};
+  // The tile of the tileset to draw.
+  mata::core::Index2d tile = {0, 0};
+  // Multiplied with the tile's colour. Sprites with a translucent tint are
+  // blended; the rest are cut out where the tile is less than half opaque.
+  glm::vec4 tint = {1.0f, 1.0f, 1.0f, 1.0f};
+  // Sprites with a greater depth are drawn over those with a lesser one.
+  // Clamped to [0, 1].
+  float depth = 0.0f;
+};
+
+} // namespace renderer
+} // namespace mata
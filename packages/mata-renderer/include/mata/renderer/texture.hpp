@@ -13,15 +13,32 @@
 namespace mata {
 namespace renderer {
 
+enum class TextureFormat {
+  // 4 bytes per pixel, rows top to bottom.
+  Rgba8,
+  // Block compressed 4x4 pixel blocks: 8 bytes per block with 1 bit alpha for
+  // BC1 (DXT1), and 16 bytes per block with 8 bit alpha for BC3 (DXT5).
+  Bc1,
+  Bc3,
+};
+
 class Texture final {
   class Impl;
   MATA_PROPAGATE_CONST(std::unique_ptr<Impl>) m_pImpl;
 
 public:
-  [[nodiscard]] static Texture fromPng(const mata::core::bytes &png);
+  [[nodiscard]] static Texture fromPng(const mata::core::bytes_view png);
 
   explicit Texture(const mata::core::GridDimensions2d &dimensions,
-                   const mata::core::bytes &rgba);
+                   mata::core::bytes rgba);
+  explicit Texture(const mata::core::GridDimensions2d &dimensions,
+                   const TextureFormat format, mata::core::bytes data);
+  // A texture viewing data that pOwner keeps alive, such as a memory mapped
+  // file, so that it can be used without copying.
+  explicit Texture(const mata::core::GridDimensions2d &dimensions,
+                   const TextureFormat format,
+                   std::shared_ptr<const void> pOwner,
+                   const mata::core::bytes_view data) noexcept;
   ~Texture() noexcept;
 
   Texture(const Texture &other) noexcept;
@@ -30,7 +47,11 @@ public:
 
   [[nodiscard]] mata::core::GridDimensions2d dimensions() const noexcept;
 
-  [[nodiscard]] const mata::core::bytes &asBytes() const noexcept;
+  [[nodiscard]] TextureFormat format() const noexcept;
+
+  // Copies of a texture share the same pixels, so the address of the
+  // returned bytes identifies the image.
+  [[nodiscard]] mata::core::bytes_view asBytes() const noexcept;
 };
 
 } // namespace renderer
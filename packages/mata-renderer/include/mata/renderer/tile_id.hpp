@@ -0,0 +1,108 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace mata {
+namespace renderer {
+
+// A cell of a tile layer: the index of a tile in its tileset, counted row by
+// row, packed into one unsigned integer together with flags that flip the
+// tile when it's drawn. The flags are in the top bits, so the packed value
+// can be uploaded as is and decoded by the tile shaders.
+//
+// As in Tiled, rotations are combinations of flips: a diagonal flip swaps the
+// tile's axes and is applied before the horizontal and vertical flips, so a
+// quarter turn clockwise is FLIP_DIAGONAL | FLIP_HORIZONTAL.
+template <typename T> class BasicTileId {
+  static_assert(std::is_unsigned<T>::value,
+                "tile ids are packed into unsigned integers");
+
+public:
+  using ValueType = T;
+
+private:
+  static constexpr auto N_BITS = std::numeric_limits<ValueType>::digits;
+
+  struct Packed {};
+
+  ValueType m_value = 0;
+
+  constexpr BasicTileId(Packed, const ValueType value) noexcept
+      : m_value(value) {}
+
+public:
+  static constexpr auto FLIP_HORIZONTAL = static_cast<ValueType>(
+      static_cast<ValueType>(1) << (N_BITS - 1));
+  static constexpr auto FLIP_VERTICAL = static_cast<ValueType>(
+      static_cast<ValueType>(1) << (N_BITS - 2));
+  static constexpr auto FLIP_DIAGONAL = static_cast<ValueType>(
+      static_cast<ValueType>(1) << (N_BITS - 3));
+  static constexpr auto FLAGS =
+      static_cast<ValueType>(FLIP_HORIZONTAL | FLIP_VERTICAL | FLIP_DIAGONAL);
+  // The highest index is reserved for empty cells.
+  static constexpr auto MAX_INDEX =
+      static_cast<int>(static_cast<ValueType>(~FLAGS)) - 1;
+
+  constexpr BasicTileId() noexcept = default;
+
+  // Unflipped; see withFlags.
+  constexpr explicit BasicTileId(const int index) noexcept
+      : m_value(static_cast<ValueType>(index)) {
+    assert(index >= 0 && index <= MAX_INDEX);
+  }
+
+  // A cell with no tile, which is never drawn.
+  [[nodiscard]] static constexpr BasicTileId empty() noexcept {
+    return BasicTileId(Packed{}, static_cast<ValueType>(~FLAGS));
+  }
+
+  // Reinterpret a packed value, such as one read back from a tile grid.
+  [[nodiscard]] static constexpr BasicTileId
+  fromValue(const ValueType value) noexcept {
+    return BasicTileId(Packed{}, value);
+  }
+
+  [[nodiscard]] constexpr int index() const noexcept {
+    return static_cast<int>(m_value & static_cast<ValueType>(~FLAGS));
+  }
+
+  [[nodiscard]] constexpr ValueType flags() const noexcept {
+    return static_cast<ValueType>(m_value & FLAGS);
+  }
+
+  [[nodiscard]] constexpr ValueType value() const noexcept { return m_value; }
+
+  // Whatever its flags.
+  [[nodiscard]] constexpr bool isEmpty() const noexcept {
+    return index() == empty().index();
+  }
+
+  [[nodiscard]] constexpr BasicTileId
+  withFlags(const ValueType flags) const noexcept {
+    return fromValue(static_cast<ValueType>(
+        (m_value & static_cast<ValueType>(~FLAGS)) | (flags & FLAGS)));
+  }
+
+  friend constexpr bool operator==(const BasicTileId &a,
+                                   const BasicTileId &b) noexcept {
+    return a.m_value == b.m_value;
+  }
+  friend constexpr bool operator!=(const BasicTileId &a,
+                                   const BasicTileId &b) noexcept {
+    return a.m_value != b.m_value;
+  }
+};
+
+// Two bytes per cell, for tilesets of up to 8191 tiles. The tile shaders
+// decode this width, so tile layers and tile grids use it throughout.
+using TileId = BasicTileId<std::uint16_t>;
+
+} // namespace renderer
+} // namespace mata
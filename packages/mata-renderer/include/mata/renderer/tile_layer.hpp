@@ -12,21 +12,59 @@
 #include <mata/utils/propagate_const.hpp>
 
 #include "texture.hpp"
+#include "tile_id.hpp"
 #include "tileset.hpp"
 
 namespace mata {
 namespace renderer {
 
+// How a tile layer stores its cells.
+enum class TileStorage {
+  // Every cell, for layers that are mostly covered in tiles.
+  Dense,
+  // Only the chunks of cells holding a tile, for mostly empty layers such as
+  // decoration; the rest take no memory.
+  Sparse,
+};
+
+// A tile and the cell of a layer it's placed in.
+struct PlacedTile {
+  mata::core::Index2d index;
+  TileId tile;
+
+  // Not an aggregate, so that braced lists of indices can't be mistaken for
+  // placed tiles.
+  constexpr PlacedTile(const mata::core::Index2d &index_,
+                       const TileId tile_) noexcept
+      : index(index_), tile(tile_) {}
+};
+
 class TileLayer final {
   class Impl;
   MATA_PROPAGATE_CONST(std::unique_ptr<Impl>) m_pImpl;
 
 public:
+  // Tiles are given row by row, with TileId::empty() for cells without one.
+  // Tiles given as indices into the tileset's grid are packed into TileIds
+  // once, here. Throws std::logic_error if the tileset has more than
+  // TileId::MAX_INDEX + 1 tiles or a tile isn't one of them.
+  TileLayer(const mata::core::GridDimensions2d &dimensions,
+            const Tileset &tileset, const std::vector<TileId> &tiles,
+            const TileStorage storage = TileStorage::Dense);
   TileLayer(const mata::core::GridDimensions2d &dimensions,
             const Tileset &tileset,
-            const std::vector<mata::core::Index2d> &tiles) noexcept;
+            const std::vector<mata::core::Index2d> &tiles);
+  // Only the placed tiles are given, and every other cell is empty, so a
+  // sparse layer is built without a full grid of tiles. Later tiles replace
+  // earlier ones in the same cell. Also throws std::logic_error if a tile is
+  // placed outside of the layer.
+  TileLayer(const mata::core::GridDimensions2d &dimensions,
+            const Tileset &tileset, const std::vector<PlacedTile> &tiles,
+            const TileStorage storage = TileStorage::Sparse);
+  // Every cell empty.
   TileLayer(const mata::core::GridDimensions2d &dimensions,
-            const Tileset &tileset) noexcept;
+            const Tileset &tileset,
+            const TileStorage storage = TileStorage::Dense);
   ~TileLayer() noexcept;
 
   TileLayer(const TileLayer &other) noexcept;
@@ -37,8 +75,15 @@ public:
 
   [[nodiscard]] const Tileset &tileset() const noexcept;
 
-  [[nodiscard]] mata::core::Index2d
-  tileAt(const mata::core::Index2d &index) const noexcept;
+  [[nodiscard]] TileStorage storage() const noexcept;
+
+  [[nodiscard]] TileId tileAt(const mata::core::Index2d &index) const noexcept;
+
+  // Whether every cell in a rectangle, clipped to the layer, is empty. Cheap
+  // for sparse layers where the rectangle covers no stored chunks.
+  [[nodiscard]] bool
+  isEmptyIn(const mata::core::Index2d &origin,
+            const mata::core::GridDimensions2d &dimensions) const noexcept;
 };
 
 } // namespace renderer
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <vector>
 
 #include <mata/core/geometry.hpp>
 #include <mata/core/types.hpp>
@@ -15,6 +17,28 @@
 namespace mata {
 namespace renderer {
 
+// How a tileset's texture arranges its tiles.
+enum class TileLayout {
+  // In a grid, as drawn in an atlas.
+  Atlas,
+  // Stacked vertically in order, as uploaded to a texture array. Tilesets
+  // with compressed textures are always stacked, whatever layout they're
+  // given.
+  Stacked,
+};
+
+struct TileAnimationFrame {
+  mata::core::Index2d tile;
+  std::chrono::milliseconds duration;
+};
+
+// Wherever the animated tile is placed, it's drawn as each frame's tile in
+// turn, looping. Every placement starts together at time 0.
+struct TileAnimation {
+  mata::core::Index2d tile;
+  std::vector<TileAnimationFrame> frames;
+};
+
 struct Tileset final {
   class Impl;
   MATA_PROPAGATE_CONST(std::unique_ptr<Impl>) m_pImpl;
@@ -22,7 +46,8 @@ struct Tileset final {
 public:
   Tileset(const mata::core::GridDimensions2d tileSize,
           const mata::core::GridDimensions2d dimensions,
-          const Texture &texture) noexcept;
+          const Texture &texture,
+          const TileLayout layout = TileLayout::Atlas) noexcept;
   ~Tileset() noexcept;
 
   Tileset(const Tileset &other) noexcept;
@@ -35,7 +60,17 @@ public:
 
   [[nodiscard]] const Texture &texture() const noexcept;
 
-  [[nodiscard]] mata::core::bytes asLinearBytes() const noexcept;
+  [[nodiscard]] TileLayout layout() const noexcept;
+
+  // Animations are resolved on the GPU from the renderer's animation time,
+  // so animating any number of tiles costs nothing per frame on the CPU.
+  void setAnimations(std::vector<TileAnimation> animations);
+  [[nodiscard]] const std::vector<TileAnimation> &animations() const noexcept;
+
+  // The pixels of every tile stacked vertically in order, as uploaded to a
+  // texture array, in the texture's format. Computed on first use and shared
+  // between copies, unless the texture is already stacked.
+  [[nodiscard]] mata::core::bytes_view asLinearBytes() const noexcept;
 };
 
 } // namespace renderer
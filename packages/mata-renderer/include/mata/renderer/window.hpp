@@ -21,13 +21,24 @@ class Window final {
   MATA_PROPAGATE_CONST(std::unique_ptr<Impl>) m_pImpl;
 
 public:
-  explicit Window(const bool headless);
+  explicit Window(const bool headless, const bool debugContext = false);
   ~Window() noexcept;
 
   GlProcAddressFunc glProcAddressFunc() const;
 
+  // Swap buffers then poll events.
   void update();
 
+  // Presenting and polling separately lets a render thread present while
+  // the main thread, which GLFW requires events be polled from, polls.
+  void swapBuffers();
+  void pollEvents();
+
+  // The GL context is current on one thread at a time: release it on the
+  // thread that has it before making it current on another.
+  void makeContextCurrent();
+  void releaseContext();
+
   using ResizeCallback =
       std::function<void(const unsigned int width, const unsigned int height)>;
 
@@ -0,0 +1,62 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <mata/core/geometry.hpp>
+#include <mata/platform/mapped_file.hpp>
+#include <mata/renderer/baked_tileset.hpp>
+#include <mata/renderer/texture.hpp>
+#include <mata/renderer/tileset.hpp>
+
+// Usage: mata-texconv <atlas.png> <tile width> <tile height> <rgba8|bc1|bc3>
+//                     <out>
+int main(int argc, char *argv[]) {
+  if (argc != 6) {
+    std::cerr << "Usage: " << argv[0]
+              << " <atlas.png> <tile width> <tile height> <rgba8|bc1|bc3>"
+                 " <out>\n";
+    return 1;
+  }
+
+  try {
+    const auto format = std::string(argv[4]);
+    if (format != "rgba8" && format != "bc1" && format != "bc3") {
+      throw std::invalid_argument("format must be rgba8, bc1 or bc3: " +
+                                  format);
+    }
+    const auto tileSize =
+        mata::core::GridDimensions2d{std::stoi(argv[2]), std::stoi(argv[3])};
+
+    const auto png = mata::platform::MappedFile(argv[1]);
+    const auto texture = mata::renderer::Texture::fromPng(png.bytes());
+    const auto textureDims = texture.dimensions();
+    const auto tileset = mata::renderer::Tileset(
+        tileSize,
+        {textureDims.nColumns / tileSize.nColumns,
+         textureDims.nRows / tileSize.nRows},
+        texture);
+    const auto baked =
+        format == "rgba8"
+            ? mata::renderer::bakeTileset(tileset)
+            : mata::renderer::compressTileset(
+                  tileset, format == "bc1"
+                               ? mata::renderer::TextureFormat::Bc1
+                               : mata::renderer::TextureFormat::Bc3);
+
+    auto output = std::ofstream(argv[5], std::ios_base::binary);
+    output.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+    output.write(reinterpret_cast<const char *>(baked.data()),
+                 static_cast<std::streamsize>(baked.size()));
+  } catch (const std::exception &error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,126 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include <mata/core/geometry.hpp>
+#include <mata/platform/virtual_file_system.hpp>
+#include <mata/utils/thread_pool.hpp>
+
+#include "mata/renderer/asset_loader.hpp"
+#include "baked_tileset_cache.hpp"
+#include "mata/renderer/baked_tileset.hpp"
+
+namespace mata {
+namespace renderer {
+
+class AssetLoader::Impl final {
+  std::shared_ptr<mata::platform::VirtualFileSystem> m_pVfs;
+  std::optional<BakedTilesetCache> m_tilesetCache;
+  // Declared last so the workers are joined before anything they use is
+  // destroyed.
+  mata::utils::ThreadPool m_pool;
+
+  static Texture readTexture(const mata::platform::VirtualFileSystem &vfs,
+                             const std::filesystem::path &path) {
+    try {
+      // Decode straight from the mapped file rather than a copy of it.
+      const auto pngFile = vfs.mapFile(path);
+      return Texture::fromPng(pngFile.bytes());
+    } catch (...) {
+      std::throw_with_nested(std::runtime_error(
+          fmt::format("failed to load texture: {0}", path.string())));
+    }
+  }
+
+public:
+  Impl(const std::shared_ptr<mata::platform::VirtualFileSystem> pVfs,
+       const std::optional<std::filesystem::path> &tilesetCachePath,
+       const std::size_t nThreads)
+      : m_pVfs(pVfs),
+        m_tilesetCache(tilesetCachePath
+                           ? std::make_optional<BakedTilesetCache>(
+                                 *tilesetCachePath)
+                           : std::nullopt),
+        m_pool(nThreads == 0 ? mata::utils::ThreadPool::defaultSize()
+                             : nThreads) {}
+
+  std::future<Texture> loadTexture(const std::filesystem::path &path) {
+    return m_pool.submit(
+        [pVfs = m_pVfs, path]() { return readTexture(*pVfs, path); });
+  }
+
+  std::future<Tileset>
+  loadTileset(const std::filesystem::path &path,
+              const mata::core::GridDimensions2d tileSize,
+              const mata::core::GridDimensions2d dimensions) {
+    if (!m_tilesetCache) {
+      return m_pool.submit([pVfs = m_pVfs, path, tileSize, dimensions]() {
+        const auto tileset =
+            Tileset(tileSize, dimensions, readTexture(*pVfs, path));
+        static_cast<void>(tileset.asLinearBytes());
+        return tileset;
+      });
+    }
+    // The cache is only ever read, and outlives the workers.
+    return m_pool.submit([pVfs = m_pVfs, &cache = *m_tilesetCache, path,
+                          tileSize, dimensions]() {
+      try {
+        const auto pngFile = pVfs->mapFile(path);
+        return cache.loadOrBake(pngFile.bytes(), tileSize, dimensions);
+      } catch (...) {
+        std::throw_with_nested(std::runtime_error(
+            fmt::format("failed to load tileset: {0}", path.string())));
+      }
+    });
+  }
+
+  std::future<Tileset>
+  loadBakedTileset(const std::filesystem::path &path) {
+    return m_pool.submit([pVfs = m_pVfs, path]() {
+      try {
+        return mata::renderer::loadBakedTileset(pVfs->mapFile(path));
+      } catch (...) {
+        std::throw_with_nested(std::runtime_error(
+            fmt::format("failed to load baked tileset: {0}", path.string())));
+      }
+    });
+  }
+};
+
+AssetLoader::AssetLoader(
+    const std::shared_ptr<mata::platform::VirtualFileSystem> pVfs,
+    const std::optional<std::filesystem::path> &tilesetCachePath,
+    const std::size_t nThreads)
+    : m_pImpl(std::make_unique<Impl>(pVfs, tilesetCachePath, nThreads)) {}
+
+AssetLoader::~AssetLoader() noexcept = default;
+
+std::future<Texture>
+AssetLoader::loadTexture(const std::filesystem::path &path) {
+  return m_pImpl->loadTexture(path);
+}
+
+std::future<Tileset>
+AssetLoader::loadBakedTileset(const std::filesystem::path &path) {
+  return m_pImpl->loadBakedTileset(path);
+}
+
+std::future<Tileset>
+AssetLoader::loadTileset(const std::filesystem::path &path,
+                         const mata::core::GridDimensions2d tileSize,
+                         const mata::core::GridDimensions2d dimensions) {
+  return m_pImpl->loadTileset(path, tileSize, dimensions);
+}
+
+} // namespace renderer
+} // namespace mata
@@ -0,0 +1,180 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include <mata/core/geometry.hpp>
+#include <mata/core/little_endian.hpp>
+#include <mata/core/types.hpp>
+#include <mata/platform/mapped_file.hpp>
+
+#include "block_compression.hpp"
+#include "mata/renderer/baked_tileset.hpp"
+
+namespace mata {
+namespace renderer {
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC = {'M', 'A', 'T', 'A', 'T', 'E', 'X', '\0'};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 40;
+
+mata::core::GridDimensions2d
+stackedDimensions(const mata::core::GridDimensions2d tileSize,
+                  const mata::core::GridDimensions2d dimensions) noexcept {
+  return {tileSize.nColumns,
+          tileSize.nRows * dimensions.nColumns * dimensions.nRows};
+}
+
+// Compressed tiles must each be a whole number of blocks, or blocks would
+// straddle two tiles once they're stacked.
+bool isWholeBlocks(const mata::core::GridDimensions2d tileSize) noexcept {
+  return tileSize.nColumns % BLOCK_SIZE == 0 &&
+         tileSize.nRows % BLOCK_SIZE == 0;
+}
+
+std::size_t layersSize(const TextureFormat format,
+                       const mata::core::GridDimensions2d stacked) noexcept {
+  if (format == TextureFormat::Rgba8) {
+    return static_cast<std::size_t>(stacked.nColumns) *
+           static_cast<std::size_t>(stacked.nRows) * 4;
+  }
+  return compressedSize(format, stacked);
+}
+
+mata::core::bytes encode(const TextureFormat format,
+                         const mata::core::GridDimensions2d tileSize,
+                         const mata::core::GridDimensions2d dimensions,
+                         const mata::core::bytes_view layers) {
+  auto file = mata::core::bytes(HEADER_SIZE + layers.size());
+  const auto pHeader = file.data();
+  std::memcpy(pHeader, MAGIC.data(), MAGIC.size());
+  const auto writeU32 = [pHeader](const std::size_t offset, const auto value) {
+    mata::core::writeLittleEndian(pHeader + offset,
+                                  static_cast<std::uint32_t>(value));
+  };
+  writeU32(8, VERSION);
+  writeU32(12, format);
+  writeU32(16, tileSize.nColumns);
+  writeU32(20, tileSize.nRows);
+  writeU32(24, dimensions.nColumns);
+  writeU32(28, dimensions.nRows);
+  mata::core::writeLittleEndian(pHeader + 32,
+                                static_cast<std::uint64_t>(layers.size()));
+  std::memcpy(pHeader + HEADER_SIZE, layers.data(), layers.size());
+  return file;
+}
+
+struct Header {
+  TextureFormat format;
+  mata::core::GridDimensions2d tileSize;
+  mata::core::GridDimensions2d dimensions;
+  mata::core::bytes_view layers;
+
+  mata::core::GridDimensions2d textureDimensions() const noexcept {
+    return {tileSize.nColumns * dimensions.nColumns,
+            tileSize.nRows * dimensions.nRows};
+  }
+};
+
+Header decode(const mata::core::bytes_view file) {
+  const auto pHeader = file.data();
+  if (file.size() < HEADER_SIZE ||
+      std::memcmp(pHeader, MAGIC.data(), MAGIC.size()) != 0) {
+    throw std::runtime_error("not a baked tileset");
+  }
+  const auto readInt = [pHeader](const std::size_t offset) {
+    return static_cast<int>(
+        mata::core::readLittleEndian<std::uint32_t>(pHeader + offset));
+  };
+  const auto version = mata::core::readLittleEndian<std::uint32_t>(pHeader + 8);
+  if (version != VERSION) {
+    throw std::runtime_error(
+        fmt::format("unsupported baked tileset version {0}", version));
+  }
+  const auto format = static_cast<TextureFormat>(readInt(12));
+  if (format != TextureFormat::Rgba8 && format != TextureFormat::Bc1 &&
+      format != TextureFormat::Bc3) {
+    throw std::runtime_error(
+        fmt::format("unsupported baked tileset format {0}", readInt(12)));
+  }
+  const auto tileSize = mata::core::GridDimensions2d{readInt(16), readInt(20)};
+  const auto dimensions =
+      mata::core::GridDimensions2d{readInt(24), readInt(28)};
+  if (format != TextureFormat::Rgba8 && !isWholeBlocks(tileSize)) {
+    throw std::runtime_error(fmt::format(
+        "baked tileset's {0}x{1} tiles can't be split into {2}x{2} blocks",
+        tileSize.nColumns, tileSize.nRows, BLOCK_SIZE));
+  }
+  const auto nBytes = mata::core::readLittleEndian<std::uint64_t>(pHeader + 32);
+  if (nBytes != layersSize(format, stackedDimensions(tileSize, dimensions)) ||
+      nBytes != file.size() - HEADER_SIZE) {
+    throw std::runtime_error("baked tileset is truncated or corrupt");
+  }
+  return {format, tileSize, dimensions,
+          {pHeader + HEADER_SIZE, static_cast<std::size_t>(nBytes)}};
+}
+
+} // namespace
+
+mata::core::bytes bakeTileset(const Tileset &tileset) {
+  return encode(tileset.texture().format(), tileset.tileSize(),
+                tileset.dimensions(), tileset.asLinearBytes());
+}
+
+mata::core::bytes compressTileset(const Tileset &tileset,
+                                  const TextureFormat format) {
+  if (format == TextureFormat::Rgba8) {
+    throw std::logic_error("tilesets can only be compressed to BC formats");
+  }
+  if (tileset.texture().format() != TextureFormat::Rgba8) {
+    throw std::logic_error("tileset is already compressed");
+  }
+
+  const auto tileSize = tileset.tileSize();
+  if (!isWholeBlocks(tileSize)) {
+    throw std::logic_error(
+        fmt::format("{0}x{1} tiles can't be split into {2}x{2} blocks",
+                    tileSize.nColumns, tileSize.nRows, BLOCK_SIZE));
+  }
+
+  // Stacking the tiles first means every tile is a whole number of blocks,
+  // one layer after the other.
+  const auto dimensions = tileset.dimensions();
+  const auto blocks =
+      compressBlocks(format, tileset.asLinearBytes(),
+                     stackedDimensions(tileSize, dimensions));
+  return encode(format, tileSize, dimensions, blocks);
+}
+
+Tileset loadBakedTileset(const mata::core::bytes_view file) {
+  const auto header = decode(file);
+  return Tileset(header.tileSize, header.dimensions,
+                 Texture(header.textureDimensions(), header.format,
+                         mata::core::bytes(header.layers.begin(),
+                                           header.layers.end())),
+                 TileLayout::Stacked);
+}
+
+Tileset loadBakedTileset(mata::platform::MappedFile file) {
+  const auto pFile =
+      std::make_shared<const mata::platform::MappedFile>(std::move(file));
+  const auto header = decode(pFile->bytes());
+  return Tileset(header.tileSize, header.dimensions,
+                 Texture(header.textureDimensions(), header.format, pFile,
+                         header.layers),
+                 TileLayout::Stacked);
+}
+
+} // namespace renderer
+} // namespace mata
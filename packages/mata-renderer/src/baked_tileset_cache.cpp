@@ -0,0 +1,126 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <ios>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include <mata/core/geometry.hpp>
+#include <mata/core/types.hpp>
+#include <mata/platform/mapped_file.hpp>
+
+#include "baked_tileset_cache.hpp"
+#include "mata/renderer/baked_tileset.hpp"
+#include "mata/renderer/texture.hpp"
+
+namespace mata {
+namespace renderer {
+
+namespace {
+
+// FNV-1a, which is plenty to tell atlases apart and much cheaper than
+// decoding them.
+constexpr std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325;
+constexpr std::uint64_t FNV_PRIME = 0x100000001b3;
+
+std::uint64_t hashBytes(std::uint64_t hash, const mata::core::byte *pBytes,
+                        const std::size_t size) noexcept {
+  for (auto i = std::size_t{0}; i < size; ++i) {
+    hash = (hash ^ pBytes[i]) * FNV_PRIME;
+  }
+  return hash;
+}
+
+std::uint64_t hashInt(const std::uint64_t hash, const int value) noexcept {
+  auto valueBytes = std::array<mata::core::byte, 4>();
+  for (auto i = std::size_t{0}; i < valueBytes.size(); ++i) {
+    valueBytes[i] =
+        static_cast<mata::core::byte>(static_cast<unsigned int>(value) >>
+                                      (8 * i));
+  }
+  return hashBytes(hash, valueBytes.data(), valueBytes.size());
+}
+
+// Bumped whenever the way tilesets are baked changes, so that stale files
+// are never loaded.
+constexpr int BAKE_VERSION = 1;
+
+} // namespace
+
+BakedTilesetCache::BakedTilesetCache(std::filesystem::path directory) noexcept
+    : m_directory(std::move(directory)) {}
+
+std::filesystem::path
+BakedTilesetCache::pathFor(const std::uint64_t key) const {
+  return m_directory / fmt::format("{0:016x}.mtex", key);
+}
+
+std::uint64_t
+BakedTilesetCache::key(const mata::core::bytes_view png,
+                       const mata::core::GridDimensions2d tileSize,
+                       const mata::core::GridDimensions2d dimensions) noexcept {
+  auto hash = hashBytes(FNV_OFFSET_BASIS, png.data(), png.size());
+  hash = hashInt(hash, BAKE_VERSION);
+  hash = hashInt(hash, tileSize.nColumns);
+  hash = hashInt(hash, tileSize.nRows);
+  hash = hashInt(hash, dimensions.nColumns);
+  return hashInt(hash, dimensions.nRows);
+}
+
+Tileset
+BakedTilesetCache::loadOrBake(const mata::core::bytes_view png,
+                              const mata::core::GridDimensions2d tileSize,
+                              const mata::core::GridDimensions2d dimensions)
+    const {
+  const auto path = this->pathFor(key(png, tileSize, dimensions));
+  auto error = std::error_code();
+  if (std::filesystem::is_regular_file(path, error)) {
+    try {
+      return loadBakedTileset(mata::platform::MappedFile(path));
+    } catch (const std::exception &loadError) {
+      // Most likely a file left behind by an older build, so bake it again.
+      std::cerr << fmt::format("Ignoring baked tileset {0}: {1}",
+                               path.string(), loadError.what())
+                << "\n";
+    }
+  }
+
+  const auto tileset = Tileset(tileSize, dimensions, Texture::fromPng(png));
+  const auto file = bakeTileset(tileset);
+  try {
+    // Write to a file of our own and rename it into place, so that another
+    // thread or process never maps a partly written tileset.
+    std::filesystem::create_directories(m_directory);
+    auto threadId = std::ostringstream();
+    threadId << std::this_thread::get_id();
+    const auto tempPath = std::filesystem::path(
+        fmt::format("{0}.{1}.tmp", path.string(), threadId.str()));
+    {
+      auto output = std::ofstream(tempPath, std::ios_base::binary);
+      output.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+      output.write(reinterpret_cast<const char *>(file.data()),
+                   static_cast<std::streamsize>(file.size()));
+    }
+    std::filesystem::rename(tempPath, path);
+  } catch (const std::exception &writeError) {
+    std::cerr << fmt::format("Failed to store baked tileset {0}: {1}",
+                             path.string(), writeError.what())
+              << "\n";
+  }
+  return tileset;
+}
+
+} // namespace renderer
+} // namespace mata
@@ -0,0 +1,45 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include <mata/core/geometry.hpp>
+#include <mata/core/types.hpp>
+
+#include "mata/renderer/tileset.hpp"
+
+namespace mata {
+namespace renderer {
+
+// A directory of tilesets baked from PNG atlases, keyed by a hash of the PNG
+// and the tileset's parameters. A warm start maps the baked file and uploads
+// it as it is, skipping both the PNG decode and the tile transposition.
+class BakedTilesetCache final {
+  std::filesystem::path m_directory;
+
+  [[nodiscard]] std::filesystem::path
+  pathFor(const std::uint64_t key) const;
+
+public:
+  explicit BakedTilesetCache(std::filesystem::path directory) noexcept;
+
+  [[nodiscard]] static std::uint64_t
+  key(const mata::core::bytes_view png,
+      const mata::core::GridDimensions2d tileSize,
+      const mata::core::GridDimensions2d dimensions) noexcept;
+
+  // Safe to call from several threads at once. A cache that can't be written
+  // to only costs the warm start, so failing to store a tileset is reported
+  // but isn't an error.
+  [[nodiscard]] Tileset
+  loadOrBake(const mata::core::bytes_view png,
+             const mata::core::GridDimensions2d tileSize,
+             const mata::core::GridDimensions2d dimensions) const;
+};
+
+} // namespace renderer
+} // namespace mata
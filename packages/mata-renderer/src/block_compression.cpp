@@ -0,0 +1,334 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include <mata/core/geometry.hpp>
+#include <mata/core/little_endian.hpp>
+#include <mata/core/types.hpp>
+
+#include "block_compression.hpp"
+
+namespace mata {
+namespace renderer {
+
+namespace {
+
+constexpr auto N_PIXELS_PER_BLOCK = std::size_t{BLOCK_SIZE * BLOCK_SIZE};
+constexpr auto N_COLOR_CHANNELS = std::size_t{4};
+
+using Color = std::array<int, N_COLOR_CHANNELS>;
+using Block = std::array<Color, N_PIXELS_PER_BLOCK>;
+
+// Round an 8 bit channel to the given number of bits and back, the way the
+// GPU expands them.
+int quantize(const int channel, const int nBits) noexcept {
+  const auto max = (1 << nBits) - 1;
+  return (channel * max + 127) / 255;
+}
+
+int expand(const int channel, const int nBits) noexcept {
+  return (channel << (8 - nBits)) | (channel >> (2 * nBits - 8));
+}
+
+std::uint16_t packRgb565(const Color &color) noexcept {
+  return static_cast<std::uint16_t>((quantize(color[0], 5) << 11) |
+                                    (quantize(color[1], 6) << 5) |
+                                    quantize(color[2], 5));
+}
+
+Color unpackRgb565(const std::uint16_t packed) noexcept {
+  return {expand((packed >> 11) & 0x1f, 5), expand((packed >> 5) & 0x3f, 6),
+          expand(packed & 0x1f, 5), 255};
+}
+
+int distance(const Color &a, const Color &b) noexcept {
+  auto sum = 0;
+  for (auto channel = std::size_t{0}; channel < 3; channel++) {
+    const auto delta = a[channel] - b[channel];
+    sum += delta * delta;
+  }
+  return sum;
+}
+
+// BC1 blocks with the first endpoint greater than the second have four
+// opaque colors; otherwise the fourth color is transparent black. BC3 color
+// blocks always have four colors.
+std::array<Color, 4> colorPalette(const std::uint16_t c0,
+                                  const std::uint16_t c1,
+                                  const bool fourColors) noexcept {
+  const auto p0 = unpackRgb565(c0);
+  const auto p1 = unpackRgb565(c1);
+  auto palette = std::array<Color, 4>{p0, p1, Color{}, Color{0, 0, 0, 0}};
+  for (auto channel = std::size_t{0}; channel < 3; channel++) {
+    if (fourColors) {
+      palette[2][channel] = (2 * p0[channel] + p1[channel]) / 3;
+      palette[3][channel] = (p0[channel] + 2 * p1[channel]) / 3;
+    } else {
+      palette[2][channel] = (p0[channel] + p1[channel]) / 2;
+    }
+  }
+  palette[2][3] = 255;
+  if (fourColors) {
+    palette[3][3] = 255;
+  }
+  return palette;
+}
+
+constexpr auto MIN_OPAQUE_ALPHA = 128;
+
+// Endpoints are the corners of the bounding box of the block's colors, and
+// each pixel picks the nearest color between them.
+void compressColorBlock(const Block &block, const bool forceFourColors,
+                        mata::core::byte *pOut) noexcept {
+  const auto hasTransparency =
+      !forceFourColors &&
+      std::any_of(block.begin(), block.end(), [](const Color &color) {
+        return color[3] < MIN_OPAQUE_ALPHA;
+      });
+  const auto isVisible = [hasTransparency](const Color &color) {
+    return !hasTransparency || color[3] >= MIN_OPAQUE_ALPHA;
+  };
+
+  auto min = Color{255, 255, 255, 255};
+  auto max = Color{0, 0, 0, 255};
+  for (const auto &color : block) {
+    if (isVisible(color)) {
+      for (auto channel = std::size_t{0}; channel < 3; channel++) {
+        min[channel] = std::min(min[channel], color[channel]);
+        max[channel] = std::max(max[channel], color[channel]);
+      }
+    }
+  }
+
+  auto c0 = packRgb565(max);
+  auto c1 = packRgb565(min);
+  // The endpoint order selects between four colors and three plus
+  // transparency.
+  if (hasTransparency ? c0 > c1 : c0 < c1) {
+    std::swap(c0, c1);
+  }
+  const auto fourColors = forceFourColors || c0 > c1;
+  const auto palette = colorPalette(c0, c1, fourColors);
+  const auto nOpaqueColors = fourColors ? std::size_t{4} : std::size_t{3};
+
+  auto indices = std::uint32_t{0};
+  for (auto pixel = std::size_t{0}; pixel < N_PIXELS_PER_BLOCK; pixel++) {
+    auto index = std::uint32_t{3};
+    if (isVisible(block[pixel])) {
+      auto bestDistance = std::numeric_limits<int>::max();
+      for (auto i = std::size_t{0}; i < nOpaqueColors; i++) {
+        const auto d = distance(block[pixel], palette[i]);
+        if (d < bestDistance) {
+          bestDistance = d;
+          index = static_cast<std::uint32_t>(i);
+        }
+      }
+    }
+    indices |= index << (2 * pixel);
+  }
+
+  mata::core::writeLittleEndian(pOut, c0);
+  mata::core::writeLittleEndian(pOut + 2, c1);
+  mata::core::writeLittleEndian(pOut + 4, indices);
+}
+
+void decompressColorBlock(const mata::core::byte *pIn,
+                          const bool forceFourColors, Block &block) noexcept {
+  const auto c0 = mata::core::readLittleEndian<std::uint16_t>(pIn);
+  const auto c1 = mata::core::readLittleEndian<std::uint16_t>(pIn + 2);
+  const auto indices = mata::core::readLittleEndian<std::uint32_t>(pIn + 4);
+  const auto palette = colorPalette(c0, c1, forceFourColors || c0 > c1);
+  for (auto pixel = std::size_t{0}; pixel < N_PIXELS_PER_BLOCK; pixel++) {
+    block[pixel] = palette[(indices >> (2 * pixel)) & 0x3];
+  }
+}
+
+std::array<int, 8> alphaPalette(const int a0, const int a1) noexcept {
+  auto palette = std::array<int, 8>{a0, a1};
+  if (a0 > a1) {
+    for (auto i = 1; i < 7; i++) {
+      palette[static_cast<std::size_t>(i + 1)] =
+          ((7 - i) * a0 + i * a1) / 7;
+    }
+  } else {
+    for (auto i = 1; i < 5; i++) {
+      palette[static_cast<std::size_t>(i + 1)] =
+          ((5 - i) * a0 + i * a1) / 5;
+    }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+  return palette;
+}
+
+void compressAlphaBlock(const Block &block, mata::core::byte *pOut) noexcept {
+  auto a0 = 0;
+  auto a1 = 255;
+  for (const auto &color : block) {
+    a0 = std::max(a0, color[3]);
+    a1 = std::min(a1, color[3]);
+  }
+  const auto palette = alphaPalette(a0, a1);
+
+  auto indices = std::uint64_t{0};
+  for (auto pixel = std::size_t{0}; pixel < N_PIXELS_PER_BLOCK; pixel++) {
+    auto index = std::uint64_t{0};
+    auto bestDistance = std::numeric_limits<int>::max();
+    for (auto i = std::size_t{0}; i < palette.size(); i++) {
+      const auto d = std::abs(block[pixel][3] - palette[i]);
+      if (d < bestDistance) {
+        bestDistance = d;
+        index = i;
+      }
+    }
+    indices |= index << (3 * pixel);
+  }
+
+  pOut[0] = static_cast<mata::core::byte>(a0);
+  pOut[1] = static_cast<mata::core::byte>(a1);
+  for (auto i = std::size_t{0}; i < 6; i++) {
+    pOut[2 + i] = static_cast<mata::core::byte>((indices >> (8 * i)) & 0xff);
+  }
+}
+
+void decompressAlphaBlock(const mata::core::byte *pIn, Block &block) noexcept {
+  const auto palette = alphaPalette(pIn[0], pIn[1]);
+  auto indices = std::uint64_t{0};
+  for (auto i = std::size_t{0}; i < 6; i++) {
+    indices |= static_cast<std::uint64_t>(pIn[2 + i]) << (8 * i);
+  }
+  for (auto pixel = std::size_t{0}; pixel < N_PIXELS_PER_BLOCK; pixel++) {
+    block[pixel][3] = palette[(indices >> (3 * pixel)) & 0x7];
+  }
+}
+
+void checkDimensions(const mata::core::GridDimensions2d dimensions) {
+  if (dimensions.nColumns % BLOCK_SIZE != 0 ||
+      dimensions.nRows % BLOCK_SIZE != 0) {
+    throw std::logic_error(
+        fmt::format("{0}x{1} image can't be split into {2}x{2} blocks",
+                    dimensions.nColumns, dimensions.nRows, BLOCK_SIZE));
+  }
+}
+
+// Visit every block of the image row by row, along with the offset of its
+// top left pixel.
+template <typename F>
+void forEachBlock(const mata::core::GridDimensions2d dimensions, F &&visit) {
+  const auto width = static_cast<std::size_t>(dimensions.nColumns);
+  const auto height = static_cast<std::size_t>(dimensions.nRows);
+  auto blockN = std::size_t{0};
+  for (auto y = std::size_t{0}; y < height; y += BLOCK_SIZE) {
+    for (auto x = std::size_t{0}; x < width; x += BLOCK_SIZE) {
+      visit(blockN++, (y * width + x) * N_COLOR_CHANNELS);
+    }
+  }
+}
+
+} // namespace
+
+std::size_t nBytesPerBlock(const TextureFormat format) noexcept {
+  switch (format) {
+  case TextureFormat::Bc1:
+    return 8;
+  case TextureFormat::Bc3:
+    return 16;
+  case TextureFormat::Rgba8:
+    break;
+  }
+  return N_PIXELS_PER_BLOCK * N_COLOR_CHANNELS;
+}
+
+std::size_t
+compressedSize(const TextureFormat format,
+               const mata::core::GridDimensions2d dimensions) noexcept {
+  return static_cast<std::size_t>(dimensions.nColumns / BLOCK_SIZE) *
+         static_cast<std::size_t>(dimensions.nRows / BLOCK_SIZE) *
+         nBytesPerBlock(format);
+}
+
+mata::core::bytes
+compressBlocks(const TextureFormat format, const mata::core::bytes_view rgba,
+               const mata::core::GridDimensions2d dimensions) {
+  assert(format != TextureFormat::Rgba8);
+  checkDimensions(dimensions);
+  const auto rowStride =
+      static_cast<std::size_t>(dimensions.nColumns) * N_COLOR_CHANNELS;
+  const auto blockSize = nBytesPerBlock(format);
+
+  auto blocks = mata::core::bytes(compressedSize(format, dimensions));
+  forEachBlock(dimensions, [&](const std::size_t blockN,
+                               const std::size_t pixelOffset) {
+    auto block = Block{};
+    for (auto pixel = std::size_t{0}; pixel < N_PIXELS_PER_BLOCK; pixel++) {
+      const auto pPixel = rgba.data() + pixelOffset +
+                          rowStride * (pixel / BLOCK_SIZE) +
+                          N_COLOR_CHANNELS * (pixel % BLOCK_SIZE);
+      block[pixel] = {pPixel[0], pPixel[1], pPixel[2], pPixel[3]};
+    }
+
+    const auto pBlock = blocks.data() + blockSize * blockN;
+    if (format == TextureFormat::Bc3) {
+      compressAlphaBlock(block, pBlock);
+      compressColorBlock(block, true, pBlock + 8);
+    } else {
+      compressColorBlock(block, false, pBlock);
+    }
+  });
+  return blocks;
+}
+
+mata::core::bytes
+decompressBlocks(const TextureFormat format,
+                 const mata::core::bytes_view blocks,
+                 const mata::core::GridDimensions2d dimensions) {
+  assert(format != TextureFormat::Rgba8);
+  checkDimensions(dimensions);
+  if (blocks.size() != compressedSize(format, dimensions)) {
+    throw std::runtime_error(
+        fmt::format("{0} bytes of blocks don't make a {1}x{2} image",
+                    blocks.size(), dimensions.nColumns, dimensions.nRows));
+  }
+  const auto rowStride =
+      static_cast<std::size_t>(dimensions.nColumns) * N_COLOR_CHANNELS;
+  const auto blockSize = nBytesPerBlock(format);
+
+  auto rgba = mata::core::bytes(static_cast<std::size_t>(dimensions.nRows) *
+                                rowStride);
+  forEachBlock(dimensions, [&](const std::size_t blockN,
+                               const std::size_t pixelOffset) {
+    auto block = Block{};
+    const auto pBlock = blocks.data() + blockSize * blockN;
+    if (format == TextureFormat::Bc3) {
+      decompressColorBlock(pBlock + 8, true, block);
+      decompressAlphaBlock(pBlock, block);
+    } else {
+      decompressColorBlock(pBlock, false, block);
+    }
+
+    for (auto pixel = std::size_t{0}; pixel < N_PIXELS_PER_BLOCK; pixel++) {
+      const auto pPixel = rgba.data() + pixelOffset +
+                          rowStride * (pixel / BLOCK_SIZE) +
+                          N_COLOR_CHANNELS * (pixel % BLOCK_SIZE);
+      for (auto channel = std::size_t{0}; channel < N_COLOR_CHANNELS;
+           channel++) {
+        pPixel[channel] = static_cast<mata::core::byte>(block[pixel][channel]);
+      }
+    }
+  });
+  return rgba;
+}
+
+} // namespace renderer
+} // namespace mata
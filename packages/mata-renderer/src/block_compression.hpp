@@ -0,0 +1,40 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+
+#include <mata/core/geometry.hpp>
+#include <mata/core/types.hpp>
+
+#include "mata/renderer/texture.hpp"
+
+namespace mata {
+namespace renderer {
+
+// The size of the blocks an image in the given format is split into.
+constexpr int BLOCK_SIZE = 4;
+
+[[nodiscard]] std::size_t nBytesPerBlock(const TextureFormat format) noexcept;
+
+[[nodiscard]] std::size_t
+compressedSize(const TextureFormat format,
+               const mata::core::GridDimensions2d dimensions) noexcept;
+
+// Compress RGBA pixels into 4x4 blocks, stored row by row. Both dimensions
+// must be multiples of the block size.
+[[nodiscard]] mata::core::bytes
+compressBlocks(const TextureFormat format, const mata::core::bytes_view rgba,
+               const mata::core::GridDimensions2d dimensions);
+
+// Decompress blocks back into RGBA pixels, for drivers that can't sample
+// compressed textures.
+[[nodiscard]] mata::core::bytes
+decompressBlocks(const TextureFormat format,
+                 const mata::core::bytes_view blocks,
+                 const mata::core::GridDimensions2d dimensions);
+
+} // namespace renderer
+} // namespace mata
@@ -2,6 +2,7 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <cmath>
 #include <memory>
 
 #include <glm/ext/matrix_transform.hpp>
@@ -18,6 +19,7 @@ namespace renderer {
 
 class Camera::Impl final {
   glm::mat4 m_transform = glm::mat4(1.0f);
+  float m_zoom = 1.0f;
 
 public:
   void translateBy(const glm::vec2 &translation) {
@@ -25,17 +27,56 @@ public:
         glm::translate(this->m_transform, glm::vec3(translation, 0.0f));
   }
 
-  [[nodiscard]] glm::mat4 viiewMatrix() const { return this->m_transform; }
+  void zoomBy(const float factor) { this->m_zoom *= factor; }
+
+  [[nodiscard]] float zoom() const noexcept { return this->m_zoom; }
+
+  void interpolate(const Impl &previous, const Impl &current,
+                   const float alpha) {
+    // The transform only ever accumulates translations, which interpolate
+    // linearly. Zoom steps multiply, so the zoom is interpolated
+    // geometrically to keep its rate even between steps.
+    this->m_transform = previous.m_transform * (1.0f - alpha) +
+                        current.m_transform * alpha;
+    this->m_zoom =
+        previous.m_zoom * std::pow(current.m_zoom / previous.m_zoom, alpha);
+  }
+
+  [[nodiscard]] glm::mat4 viiewMatrix() const {
+    // Zoom after translating so that the view scales about the screen's
+    // centre rather than the world's origin.
+    return glm::scale(glm::mat4(1.0f), glm::vec3(m_zoom, m_zoom, 1.0f)) *
+           this->m_transform;
+  }
 };
 
 Camera::Camera() : m_pImpl(std::make_unique<Impl>()) {}
 
 Camera::~Camera() noexcept = default;
 
+Camera::Camera(const Camera &other)
+    : m_pImpl(std::make_unique<Impl>(*other.m_pImpl)) {}
+
+Camera &Camera::operator=(const Camera &other) {
+  *this->m_pImpl = *other.m_pImpl;
+  return *this;
+}
+
+Camera Camera::interpolate(const Camera &previous, const Camera &current,
+                           const float alpha) {
+  auto camera = Camera();
+  camera.m_pImpl->interpolate(*previous.m_pImpl, *current.m_pImpl, alpha);
+  return camera;
+}
+
 void Camera::translateBy(const glm::vec2 &translation) {
   this->m_pImpl->translateBy(translation);
 }
 
+void Camera::zoomBy(const float factor) { this->m_pImpl->zoomBy(factor); }
+
+float Camera::zoom() const noexcept { return this->m_pImpl->zoom(); }
+
 glm::mat4 Camera::viewMatrix() const { return this->m_pImpl->viiewMatrix(); }
 
 } // namespace renderer
@@ -0,0 +1,83 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+
+#include <glbinding/gl33core/gl.h>
+
+#include "gpu_timer.hpp"
+
+using namespace gl;
+
+namespace mata {
+namespace renderer {
+
+GpuTimer::GpuTimer(Profiler &profiler) noexcept : m_profiler(profiler) {}
+
+GpuTimer::~GpuTimer() noexcept {
+  for (auto &frame : m_frames) {
+    glDeleteQueries(static_cast<GLsizei>(frame.queries.size()),
+                    frame.queries.data());
+  }
+}
+
+void GpuTimer::collect(FrameQueries &frame) {
+  auto offset = ProfileClock::duration{0};
+  for (auto n = std::size_t{0}; n < frame.nUsed; n++) {
+    auto available = GLint{0};
+    glGetQueryObjectiv(frame.queries[n], GL_QUERY_RESULT_AVAILABLE,
+                       &available);
+    if (available == 0) {
+      continue;
+    }
+    auto elapsedNs = GLuint64{0};
+    glGetQueryObjectui64v(frame.queries[n], GL_QUERY_RESULT, &elapsedNs);
+    const auto elapsed = std::chrono::duration_cast<ProfileClock::duration>(
+        std::chrono::nanoseconds(elapsedNs));
+    m_profiler.recordGpu(frame.frameNumber, frame.names[n],
+                         frame.startedAt + offset, elapsed);
+    offset += elapsed;
+  }
+  frame.nUsed = 0;
+}
+
+void GpuTimer::beginFrame() {
+  if (m_timing) {
+    throw std::logic_error("GPU timer frame began inside a span");
+  }
+  m_frame = (m_frame + 1) % N_FRAMES;
+  auto &frame = m_frames[m_frame];
+  this->collect(frame);
+  frame.frameNumber = m_profiler.frameNumber();
+  frame.startedAt = ProfileClock::now();
+}
+
+void GpuTimer::begin(const char *name) {
+  if (m_timing) {
+    throw std::logic_error("GPU timer spans can't nest");
+  }
+  auto &frame = m_frames[m_frame];
+  if (frame.nUsed == frame.queries.size()) {
+    auto query = GLuint{0};
+    glGenQueries(1, &query);
+    frame.queries.push_back(query);
+    frame.names.push_back(nullptr);
+  }
+  frame.names[frame.nUsed] = name;
+  glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.nUsed]);
+  frame.nUsed++;
+  m_timing = true;
+}
+
+void GpuTimer::end() noexcept {
+  assert(m_timing);
+  glEndQuery(GL_TIME_ELAPSED);
+  m_timing = false;
+}
+
+} // namespace renderer
+} // namespace mata
@@ -0,0 +1,84 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glbinding/gl/types.h>
+
+#include <mata/utils/noncopyable.hpp>
+
+#include "mata/renderer/profiler.hpp"
+
+namespace mata {
+namespace renderer {
+
+// Times spans of GL commands with GL_TIME_ELAPSED queries and records them
+// with a profiler. Each frame's queries are read back N_FRAMES frames later,
+// just before they're reused, and only if the GPU has finished them, so
+// timing never stalls the CPU; results that aren't ready are dropped.
+//
+// Elapsed time queries can't nest, so spans must not overlap, and they carry
+// no timestamps: a frame's spans are laid out back to back from when the
+// frame started on the CPU.
+class GpuTimer final : mata::utils::noncopyable {
+public:
+  static constexpr std::size_t N_FRAMES = 2;
+
+private:
+  struct FrameQueries {
+    std::uint64_t frameNumber = 0;
+    ProfileClock::time_point startedAt{};
+    std::vector<gl::GLuint> queries{};
+    std::vector<const char *> names{};
+    std::size_t nUsed = 0;
+  };
+
+  Profiler &m_profiler;
+  std::array<FrameQueries, N_FRAMES> m_frames{};
+  std::size_t m_frame = 0;
+  bool m_timing = false;
+
+  void collect(FrameQueries &frame);
+
+public:
+  // Must be created and destroyed with the GL context current.
+  explicit GpuTimer(Profiler &profiler) noexcept;
+  ~GpuTimer() noexcept;
+
+  // Read back the oldest frame's timings and reuse its queries for a new
+  // frame of the profiler's.
+  void beginFrame();
+
+  void begin(const char *name);
+  void end() noexcept;
+
+  // Times GL commands from construction to destruction. Does nothing without
+  // a timer, like Profiler::Scope.
+  class Span final {
+    GpuTimer *m_pTimer;
+
+  public:
+    Span(GpuTimer *pTimer, const char *name) : m_pTimer(pTimer) {
+      if (m_pTimer != nullptr) {
+        m_pTimer->begin(name);
+      }
+    }
+    ~Span() noexcept {
+      if (m_pTimer != nullptr) {
+        m_pTimer->end();
+      }
+    }
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+  };
+};
+
+} // namespace renderer
+} // namespace mata
@@ -0,0 +1,81 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include <mata/core/geometry.hpp>
+#include <mata/core/types.hpp>
+
+#include "mipmaps.hpp"
+
+namespace mata {
+namespace renderer {
+
+namespace {
+
+constexpr std::size_t N_COLOR_CHANNELS = 4; // rgba
+
+} // namespace
+
+mata::core::GridDimensions2d
+mipLevelSize(const mata::core::GridDimensions2d size) noexcept {
+  return {std::max(1, size.nColumns / 2), std::max(1, size.nRows / 2)};
+}
+
+mata::core::bytes downsampleLayers(const mata::core::bytes_view rgba,
+                                   const mata::core::GridDimensions2d layerSize,
+                                   const int nLayers) {
+  const auto srcCols = static_cast<std::size_t>(layerSize.nColumns);
+  const auto srcRows = static_cast<std::size_t>(layerSize.nRows);
+  const auto destSize = mipLevelSize(layerSize);
+  const auto destCols = static_cast<std::size_t>(destSize.nColumns);
+  const auto destRows = static_cast<std::size_t>(destSize.nRows);
+
+  auto result = mata::core::bytes(destCols * destRows *
+                                  static_cast<std::size_t>(nLayers) *
+                                  N_COLOR_CHANNELS);
+  auto pDest = result.data();
+  for (auto layer = std::size_t{0}; layer < static_cast<std::size_t>(nLayers);
+       layer++) {
+    const auto pLayer = rgba.data() + srcCols * srcRows * layer *
+                                          N_COLOR_CHANNELS;
+    for (auto y = std::size_t{0}; y < destRows; y++) {
+      // Odd sizes drop their last row or column, and layers a pixel high or
+      // wide reuse it, rather than sampling the next layer over.
+      const auto srcY0 = std::min(2 * y, srcRows - 1);
+      const auto srcY1 = std::min(2 * y + 1, srcRows - 1);
+      for (auto x = std::size_t{0}; x < destCols; x++) {
+        const auto srcX0 = std::min(2 * x, srcCols - 1);
+        const auto srcX1 = std::min(2 * x + 1, srcCols - 1);
+        const auto samples = std::array<const mata::core::byte *, 4>{
+            pLayer + (srcY0 * srcCols + srcX0) * N_COLOR_CHANNELS,
+            pLayer + (srcY0 * srcCols + srcX1) * N_COLOR_CHANNELS,
+            pLayer + (srcY1 * srcCols + srcX0) * N_COLOR_CHANNELS,
+            pLayer + (srcY1 * srcCols + srcX1) * N_COLOR_CHANNELS};
+
+        auto alphaSum = 0u;
+        auto colorSums = std::array<unsigned int, 3>{};
+        for (const auto pSample : samples) {
+          const auto alpha = static_cast<unsigned int>(pSample[3]);
+          alphaSum += alpha;
+          for (auto c = std::size_t{0}; c < colorSums.size(); c++) {
+            colorSums[c] += static_cast<unsigned int>(pSample[c]) * alpha;
+          }
+        }
+        for (auto c = std::size_t{0}; c < colorSums.size(); c++) {
+          pDest[c] = static_cast<mata::core::byte>(
+              alphaSum == 0 ? 0 : (colorSums[c] + alphaSum / 2) / alphaSum);
+        }
+        pDest[3] = static_cast<mata::core::byte>((alphaSum + 2) / 4);
+        pDest += N_COLOR_CHANNELS;
+      }
+    }
+  }
+  return result;
+}
+
+} // namespace renderer
+} // namespace mata
@@ -0,0 +1,27 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <mata/core/geometry.hpp>
+#include <mata/core/types.hpp>
+
+namespace mata {
+namespace renderer {
+
+// The size of the next mip level down, never smaller than a pixel.
+[[nodiscard]] mata::core::GridDimensions2d
+mipLevelSize(const mata::core::GridDimensions2d size) noexcept;
+
+// Halve each of nLayers RGBA8 layers stacked vertically, as a tileset's
+// linear bytes are. Each layer is filtered on its own so that tiles never
+// bleed into their neighbours, and colours are weighted by alpha so that
+// transparent pixels don't darken the edges of sprites.
+[[nodiscard]] mata::core::bytes
+downsampleLayers(const mata::core::bytes_view rgba,
+                 const mata::core::GridDimensions2d layerSize,
+                 const int nLayers);
+
+} // namespace renderer
+} // namespace mata
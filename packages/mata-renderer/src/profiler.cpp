@@ -0,0 +1,209 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "mata/renderer/profiler.hpp"
+
+namespace mata {
+namespace renderer {
+
+namespace {
+
+constexpr auto NO_FRAME = std::numeric_limits<std::uint64_t>::max();
+
+struct Frame {
+  std::uint64_t number = NO_FRAME;
+  std::vector<ProfileEvent> events{};
+};
+
+[[nodiscard]] double microseconds(const ProfileClock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+} // namespace
+
+class Profiler::Impl final {
+  // Recording takes a lock, which at a few dozen events a frame costs far
+  // less than the spans being timed.
+  mutable std::mutex m_mutex{};
+  std::vector<Frame> m_frames;
+  std::uint64_t m_frameNumber = 0;
+  std::unordered_map<std::thread::id, std::uint32_t> m_tracks{};
+  ProfileClock::time_point m_epoch = ProfileClock::now();
+
+  [[nodiscard]] Frame *findFrame(const std::uint64_t frameNumber) noexcept {
+    auto &frame = m_frames[frameNumber % m_frames.size()];
+    return frame.number == frameNumber ? &frame : nullptr;
+  }
+
+  [[nodiscard]] const Frame *
+  findFrame(const std::uint64_t frameNumber) const noexcept {
+    const auto &frame = m_frames[frameNumber % m_frames.size()];
+    return frame.number == frameNumber ? &frame : nullptr;
+  }
+
+  // Threads are numbered in the order they first record something, after
+  // the GPU's track.
+  [[nodiscard]] std::uint32_t currentTrack() {
+    const auto [it, inserted] = m_tracks.try_emplace(
+        std::this_thread::get_id(),
+        static_cast<std::uint32_t>(m_tracks.size()) + GPU_TRACK + 1);
+    return it->second;
+  }
+
+  // Recording can't throw as scopes record from their destructors; an event
+  // that can't be stored is dropped instead.
+  static void push(Frame &frame, const ProfileEvent &event) noexcept {
+    try {
+      frame.events.push_back(event);
+    } catch (...) {
+    }
+  }
+
+public:
+  explicit Impl(const std::size_t nFramesKept) : m_frames(nFramesKept) {
+    if (nFramesKept == 0) {
+      throw std::logic_error("profiler needs to keep at least one frame");
+    }
+    m_frames[0].number = 0;
+  }
+
+  [[nodiscard]] std::uint64_t frameNumber() const noexcept {
+    auto lock = std::lock_guard<std::mutex>(m_mutex);
+    return m_frameNumber;
+  }
+
+  void recordCpu(const char *name, const ProfileClock::time_point start,
+                 const ProfileClock::time_point end) noexcept {
+    auto lock = std::lock_guard<std::mutex>(m_mutex);
+    auto track = GPU_TRACK;
+    try {
+      track = this->currentTrack();
+    } catch (...) {
+      return;
+    }
+    push(*this->findFrame(m_frameNumber), {name, track, start, end - start});
+  }
+
+  void recordGpu(const std::uint64_t frameNumber, const char *name,
+                 const ProfileClock::time_point start,
+                 const ProfileClock::duration duration) noexcept {
+    auto lock = std::lock_guard<std::mutex>(m_mutex);
+    auto *pFrame = this->findFrame(frameNumber);
+    if (pFrame != nullptr) {
+      push(*pFrame, {name, GPU_TRACK, start, duration});
+    }
+  }
+
+  void endFrame() noexcept {
+    auto lock = std::lock_guard<std::mutex>(m_mutex);
+    m_frameNumber++;
+    auto &frame = m_frames[m_frameNumber % m_frames.size()];
+    frame.number = m_frameNumber;
+    // Keeps the capacity, so that steady state recording doesn't allocate.
+    frame.events.clear();
+  }
+
+  [[nodiscard]] std::vector<ProfileEvent>
+  frameEvents(const std::uint64_t frameNumber) const {
+    auto lock = std::lock_guard<std::mutex>(m_mutex);
+    const auto *pFrame = this->findFrame(frameNumber);
+    return pFrame != nullptr ? pFrame->events : std::vector<ProfileEvent>{};
+  }
+
+  void writeChromeTrace(std::ostream &out) const {
+    auto lock = std::lock_guard<std::mutex>(m_mutex);
+    out << "{\"traceEvents\":[";
+    fmt::print(out, R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},)"
+                    R"("args":{{"name":"GPU"}}}})",
+               GPU_TRACK);
+    for (const auto &[threadId, track] : m_tracks) {
+      fmt::print(out,
+                 R"(,{{"name":"thread_name","ph":"M","pid":1,"tid":{},)"
+                 R"("args":{{"name":"CPU thread {}"}}}})",
+                 track, track);
+    }
+    const auto nFrames = static_cast<std::uint64_t>(m_frames.size());
+    const auto oldest = m_frameNumber >= nFrames ? m_frameNumber - nFrames + 1
+                                                 : std::uint64_t{0};
+    for (auto frameNumber = oldest; frameNumber <= m_frameNumber;
+         frameNumber++) {
+      const auto *pFrame = this->findFrame(frameNumber);
+      if (pFrame == nullptr) {
+        continue;
+      }
+      for (const auto &event : pFrame->events) {
+        fmt::print(out,
+                   R"(,{{"name":"{}","ph":"X","pid":1,"tid":{},)"
+                   R"("ts":{:.3f},"dur":{:.3f},"args":{{"frame":{}}}}})",
+                   event.name, event.track,
+                   microseconds(event.start - m_epoch),
+                   microseconds(event.duration), frameNumber);
+      }
+    }
+    out << "]}\n";
+  }
+};
+
+Profiler::Scope::Scope(Profiler *pProfiler, const char *name) noexcept
+    : m_pProfiler(pProfiler), m_name(name) {
+  if (m_pProfiler != nullptr) {
+    m_start = ProfileClock::now();
+  }
+}
+
+Profiler::Scope::~Scope() noexcept {
+  if (m_pProfiler != nullptr) {
+    m_pProfiler->recordCpu(m_name, m_start, ProfileClock::now());
+  }
+}
+
+Profiler::Profiler(const std::size_t nFramesKept)
+    : m_pImpl(std::make_unique<Impl>(nFramesKept)) {}
+
+Profiler::~Profiler() noexcept = default;
+
+std::uint64_t Profiler::frameNumber() const noexcept {
+  return m_pImpl->frameNumber();
+}
+
+void Profiler::recordCpu(const char *name,
+                         const ProfileClock::time_point start,
+                         const ProfileClock::time_point end) noexcept {
+  m_pImpl->recordCpu(name, start, end);
+}
+
+void Profiler::recordGpu(const std::uint64_t frameNumber, const char *name,
+                         const ProfileClock::time_point start,
+                         const ProfileClock::duration duration) noexcept {
+  m_pImpl->recordGpu(frameNumber, name, start, duration);
+}
+
+void Profiler::endFrame() noexcept { m_pImpl->endFrame(); }
+
+std::vector<ProfileEvent>
+Profiler::frameEvents(const std::uint64_t frameNumber) const {
+  return m_pImpl->frameEvents(frameNumber);
+}
+
+void Profiler::writeChromeTrace(std::ostream &out) const {
+  m_pImpl->writeChromeTrace(out);
+}
+
+} // namespace renderer
+} // namespace mata
@@ -3,28 +3,55 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <list>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <stdio.h>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include <fmt/core.h>
+#include <glbinding-aux/ContextInfo.h>
 #include <glbinding/Binding.h>
+#include <glbinding/gl/extension.h>
 #include <glbinding/gl33core/gl.h>
 #include <glbinding/glbinding.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/matrix.hpp>
 #include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
 
 #include <mata/core/geometry.hpp>
 #include <mata/platform/virtual_file_system.hpp>
 
+#include "block_compression.hpp"
+#include "gpu_timer.hpp"
+#include "mipmaps.hpp"
+#include "stream_buffer.hpp"
+#include "tile_animations.hpp"
+#include "tile_layer_mesh.hpp"
+#include "mata/renderer/profiler.hpp"
 #include "mata/renderer/renderer.hpp"
+#include "mata/renderer/sprite.hpp"
+#include "mata/renderer/tile_id.hpp"
 #include "mata/renderer/tile_layer.hpp"
 
 using namespace gl;
@@ -53,113 +80,579 @@ inline std::string readableErrorCode(const gl::GLenum errorCode) {
   return "Unknown Error";
 }
 
-struct Vertex {
-  using PositionType = glm::vec2;
-  using TextureCoordsType = glm::vec2;
+// Errors reported by the driver outside of the call that caused them, either
+// through the debug message callback or by polling glGetError.
+class GlErrorLog {
+  std::vector<std::string> m_errors{};
 
-  PositionType position;
-  TextureCoordsType textureCoords;
+public:
+  void add(std::string message) { m_errors.push_back(std::move(message)); }
+
+  // Poll glGetError until the driver's error flags are all cleared.
+  void poll() {
+    for (auto errorCode = glGetError(); errorCode != GL_NO_ERROR;
+         errorCode = glGetError()) {
+      if (errorCode == GL_OUT_OF_MEMORY) {
+        throw std::runtime_error("OpenGL driver reported out of memory");
+      }
+      add(readableErrorCode(errorCode));
+    }
+  }
+
+  // Report the errors logged since the last call, following the same policy
+  // as per-call checking: fatal in debug builds and ignored otherwise.
+  void report(const std::string_view context) {
+    if (m_errors.empty()) {
+      return;
+    }
+#ifndef NDEBUG
+    for (const auto &error : m_errors) {
+      std::cerr << fmt::format("{0}: {1}", context, error) << "\n";
+    }
+    std::terminate();
+#else
+    static_cast<void>(context);
+    m_errors.clear();
+#endif
+  }
+};
+
+inline void handleGlDebugMessage(
+    [[maybe_unused]] const GLenum source, const GLenum type,
+    [[maybe_unused]] const GLuint id, const GLenum severity,
+    const GLsizei length, const GLchar *message, const void *userParam) {
+  // The callback may be invoked from inside the driver, so errors are only
+  // logged here and handled at the end of the frame.
+  if (type != GL_DEBUG_TYPE_ERROR && severity != GL_DEBUG_SEVERITY_HIGH) {
+    return;
+  }
+  const auto pLog = static_cast<GlErrorLog *>(const_cast<void *>(userParam));
+  pLog->add(length < 0
+                ? std::string(message)
+                : std::string(message, static_cast<std::size_t>(length)));
+}
+
+// Every tile is drawn as an instance of the same unit quad, so the only
+// vertex data is one corner per quad vertex. The corner doubles as the
+// normalized texture coordinates mapped to that corner of the tile image:
+//
+//                 , (0,0)-------(1,0)
+// a-------c <- '     |     _     |
+// |  / \ *|          |   /   \ * |
+// |  \ /  |          |   \   /   |
+// | \-+-/ |          |  \--+--/  |
+// b-------d <- ,     |   \   /   |
+//                ` (0,1)-------(1,1)
+//
+// The quad is drawn as a triangle strip [a, b, c, d], which splits it into
+// triangles with counter-clockwise winding:
+//
+// a-------c    t1 = [a, b, c]
+// | t1  / |    t2 = [b, d, c]
+// |   /   |
+// | /  t2 |
+// b-------d
+struct QuadVertex {
+  using CornerType = glm::vec2;
+
+  CornerType corner;
+};
+
+static const QuadVertex UNIT_QUAD[] = {
+    {{0.0f, 0.0f}}, // a
+    {{0.0f, 1.0f}}, // b
+    {{1.0f, 0.0f}}, // c
+    {{1.0f, 1.0f}}, // d
 };
 
-class TileLayerMesh {
+// Per-sprite instance data, streamed every frame in draw order.
+struct SpriteInstance {
+  glm::vec2 position;
+  glm::vec2 size;
+  std::int32_t tileIndex;
+  float depth;
+  std::array<std::uint8_t, 4> tint;
+};
+
+static const auto N_QUAD_VERTICES =
+    static_cast<GLsizei>(sizeof(UNIT_QUAD) / sizeof(QuadVertex));
+
+static constexpr auto MAX_LAYER_SIZE = static_cast<int>(
+    std::numeric_limits<TileInstance::GridPositionType>::max());
+
+// In LayerRenderMode::TileMap the layer's packed tile ids are uploaded as is,
+// as a 16-bit integer texture.
+using TileGridIndex = TileId::ValueType;
+static_assert(sizeof(TileGridIndex) == 2,
+              "tile grids are uploaded as GL_R16UI textures");
+
+// The stream buffer starts with this much room per frame, and grows if a
+// frame needs more.
+static constexpr std::size_t STREAM_BUFFER_FRAME_CAPACITY = 1024 * 1024;
+
+// Cut out sprites discard fragments less opaque than this.
+static constexpr auto SPRITE_ALPHA_CUTOFF = 0.5f;
+
+// Ranges of elements in a buffer that have been modified on the CPU and need
+// to be uploaded again. Ranges are coalesced when flushed, so that editing
+// many nearby elements results in few uploads.
+class DirtyRanges {
 private:
-  std::vector<Vertex> m_vertices = {};
-  std::vector<int> m_tileIndices = {};
+  // Ranges separated by fewer clean elements than this are uploaded as one.
+  static constexpr std::size_t MERGE_GAP = 64;
+
+  std::vector<std::pair<std::size_t, std::size_t>> m_ranges = {};
 
 public:
-  TileLayerMesh(const TileLayer &layer) noexcept {
-    const auto dimensions = layer.dimensions();
-    const auto tileset = layer.tileset();
-    for (auto j = 0; j < dimensions.nRows; j++) {
-      for (auto i = 0; i < dimensions.nColumns; i++) {
-        const auto tileIdx =
-            index2dTo1d(layer.tileAt({i, j}), tileset.dimensions());
-
-        // TODO: use indices to share vertices b and c.
-
-        // Each quad has normalized texture coordinates mapped to the
-        // corresponding corner of the tile image:
-        //
-        //                 , (0,0)-------(1,0)
-        // a-------c <- '     |     _     |
-        // |  / \ *|          |   /   \ * |
-        // |  \ /  |          |   \   /   |
-        // | \-+-/ |          |  \--+--/  |
-        // b-------d <- ,     |   \   /   |
-        //                ` (0,1)-------(1,1)
-        //
-        // We must also split up the tile into triangles with counter-clockwise
-        // winding:
-        //
-        // a-------c    t1 = [a, b, c]
-        // | t1  / |    t2 = [b, d, c]
-        // |   /   |
-        // | /  t2 |
-        // b-------d
-
-        // t1.a
-        m_vertices.push_back(
-            {{static_cast<float>(i), static_cast<float>(j)}, {0.0f, 0.0f}});
-        m_tileIndices.push_back(tileIdx);
-
-        // t1.b
-        m_vertices.push_back(
-            {{static_cast<float>(i), static_cast<float>(j + 1)}, {0.0f, 1.0f}});
-        m_tileIndices.push_back(tileIdx);
-
-        // t1.c
-        m_vertices.push_back(
-            {{static_cast<float>(i + 1), static_cast<float>(j)}, {1.0f, 0.0f}});
-        m_tileIndices.push_back(tileIdx);
-
-        // t2.b
-        m_vertices.push_back(
-            {{static_cast<float>(i), static_cast<float>(j + 1)}, {0.0f, 1.0f}});
-        m_tileIndices.push_back(tileIdx);
-
-        // t2.d
-        m_vertices.push_back(
-            {{static_cast<float>(i + 1), static_cast<float>(j + 1)},
-             {1.0f, 1.0f}});
-        m_tileIndices.push_back(tileIdx);
-
-        // t2.c
-        m_vertices.push_back(
-            {{static_cast<float>(i + 1), static_cast<float>(j)}, {1.0f, 0.0f}});
-        m_tileIndices.push_back(tileIdx);
+  void add(const std::size_t begin, const std::size_t end) {
+    m_ranges.emplace_back(begin, end);
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return m_ranges.empty(); }
+
+  template <typename F> void flush(F &&upload) {
+    std::sort(m_ranges.begin(), m_ranges.end());
+    auto current = m_ranges.front();
+    for (const auto &range : m_ranges) {
+      if (range.first > current.second + MERGE_GAP) {
+        upload(current.first, current.second);
+        current = range;
+      } else {
+        current.second = std::max(current.second, range.second);
       }
     }
+    upload(current.first, current.second);
+    m_ranges.clear();
   }
+};
 
-  const std::vector<Vertex> &vertices() const noexcept { return m_vertices; }
+// A rectangle of tiles [min, max) in a layer's tile grid.
+struct TileRect {
+  mata::core::Index2d min;
+  mata::core::Index2d max;
 
-  const std::vector<int> &tileIndices() const noexcept { return m_tileIndices; }
+  void extend(const TileRect &other) noexcept {
+    min = {std::min(min.i, other.min.i), std::min(min.j, other.min.j)};
+    max = {std::max(max.i, other.max.i), std::max(max.j, other.max.j)};
+  }
+};
 
-  int nIndices() const noexcept { return static_cast<int>(m_vertices.size()); }
+struct ChunkH {
+  buffer_h vao;
+  std::size_t firstInstance;
+  int nInstances;
+  TileBounds bounds;
 };
 
 struct LayerH {
-  buffer_h vao;
-  int nIndices;
+  LayerRenderMode mode;
+  mata::core::GridDimensions2d dimensions;
+  mata::core::GridDimensions2d tilesetDimensions;
+  TileBounds bounds;
+
+  // LayerRenderMode::Mesh
+  mata::core::GridDimensions2d nChunks;
+  std::vector<ChunkH> chunks;
+  buffer_h instanceBuffer;
+  // CPU copy of the instance buffer, chunk by chunk, kept so that edited
+  // tiles can be uploaded without rebuilding the mesh. Instances are in no
+  // particular order within their chunk.
+  std::vector<std::vector<TileInstance>> chunkInstances;
+  // Instances edited in place, by their index in the instance buffer.
+  DirtyRanges dirtyInstances;
+  // Set when edits added or removed instances, which moves the chunks after
+  // them in the instance buffer. The buffer is then rebuilt once, with the
+  // chunks' vertex arrays, instead of uploading dirtyInstances.
+  bool instancesMoved;
+
+  // LayerRenderMode::TileMap
+  texture_h tileGrid;
+  // CPU copy of the tile grid texture.
+  std::vector<TileGridIndex> tileGridIndices;
+  std::optional<TileRect> dirtyTileGrid;
+
+  texture_h texture;
+  texture_h animations;
+};
+
+// Tracks the GL state that the renderer changes so that redundant binds can
+// be skipped. Every bind of a program, vertex array or texture has to go
+// through here for the tracked state to stay accurate.
+class GlState {
+public:
+  struct Counters {
+    unsigned int changes = 0;
+    unsigned int avoided = 0;
+  };
+
+private:
+  static constexpr std::size_t N_TEXTURE_UNITS = 3;
+
+  shaderprogram_h m_program{0};
+  buffer_h m_vertexArray{0};
+  std::size_t m_activeTextureUnit = 0;
+  std::array<texture_h, N_TEXTURE_UNITS> m_textures2d{};
+  std::array<texture_h, N_TEXTURE_UNITS> m_textures2dArray{};
+  std::array<texture_h, N_TEXTURE_UNITS> m_texturesBuffer{};
+  bool m_blend = false;
+  bool m_depthTest = false;
+  bool m_depthWrite = true;
+  Counters m_counters{};
+
+  template <typename T> bool change(T &current, const T value) noexcept {
+    if (current == value) {
+      m_counters.avoided++;
+      return false;
+    }
+    current = value;
+    m_counters.changes++;
+    return true;
+  }
+
+  texture_h &boundTexture(const std::size_t unit, const GLenum target) {
+    assert(unit < N_TEXTURE_UNITS);
+    assert(target == GL_TEXTURE_2D || target == GL_TEXTURE_2D_ARRAY ||
+           target == GL_TEXTURE_BUFFER);
+    if (target == GL_TEXTURE_2D_ARRAY) {
+      return m_textures2dArray[unit];
+    }
+    if (target == GL_TEXTURE_BUFFER) {
+      return m_texturesBuffer[unit];
+    }
+    return m_textures2d[unit];
+  }
+
+  void activeTexture(const std::size_t unit) {
+    if (change(m_activeTextureUnit, unit)) {
+      glActiveTexture(static_cast<GLenum>(
+          static_cast<unsigned int>(GL_TEXTURE0) + unit));
+    }
+  }
+
+public:
+  void useProgram(const shaderprogram_h program) {
+    if (change(m_program, program)) {
+      glUseProgram(program);
+    }
+  }
+
+  void bindVertexArray(const buffer_h vertexArray) {
+    if (change(m_vertexArray, vertexArray)) {
+      glBindVertexArray(vertexArray);
+    }
+  }
+
+  void bindTexture(const std::size_t unit, const GLenum target,
+                   const texture_h texture) {
+    if (boundTexture(unit, target) == texture) {
+      m_counters.avoided++;
+      return;
+    }
+    activeTexture(unit);
+    change(boundTexture(unit, target), texture);
+    glBindTexture(target, texture);
+  }
+
+  // Bind a texture to whichever unit is active, for uploads.
+  void bindTexture(const GLenum target, const texture_h texture) {
+    bindTexture(m_activeTextureUnit, target, texture);
+  }
+
+  void setBlend(const bool enabled) {
+    if (change(m_blend, enabled)) {
+      if (enabled) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      } else {
+        glDisable(GL_BLEND);
+      }
+    }
+  }
+
+  void setDepthTest(const bool enabled) {
+    if (change(m_depthTest, enabled)) {
+      if (enabled) {
+        glEnable(GL_DEPTH_TEST);
+      } else {
+        glDisable(GL_DEPTH_TEST);
+      }
+    }
+  }
+
+  void setDepthWrite(const bool enabled) {
+    if (change(m_depthWrite, enabled)) {
+      glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    }
+  }
+
+  // Deleting bound objects implicitly unbinds them.
+  void deleteVertexArray(const buffer_h vertexArray) {
+    if (m_vertexArray == vertexArray) {
+      m_vertexArray = 0;
+    }
+    glDeleteVertexArrays(1, &vertexArray);
+  }
+
+  void deleteTexture(const texture_h texture) {
+    for (auto unit = std::size_t{0}; unit < N_TEXTURE_UNITS; unit++) {
+      for (const auto target :
+           {GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BUFFER}) {
+        if (boundTexture(unit, target) == texture) {
+          boundTexture(unit, target) = 0;
+        }
+      }
+    }
+    glDeleteTextures(1, &texture);
+  }
+
+  // Return the counters accumulated since the last call and reset them.
+  Counters takeCounters() noexcept { return std::exchange(m_counters, {}); }
+
+  void countAvoided() noexcept { m_counters.avoided++; }
+  void countChange() noexcept { m_counters.changes++; }
+};
+
+// A tileset's texture array and the buffer texture of its animation table.
+struct TilesetH {
+  texture_h texture;
+  texture_h animations;
+  buffer_h animationBuffer;
+};
+
+// Reference counted tileset textures, shared between every layer that uses
+// the same tileset. Textures that are no longer referenced stay uploaded
+// until evictUnused is called, so setting a layer again with a tileset that
+// was just released doesn't upload it again.
+class TilesetCache {
+private:
+  struct Entry {
+    // Holding a copy of the tileset keeps its pixels, and so their address,
+    // alive for as long as the entry exists.
+    Tileset tileset;
+    TilesetH handles;
+    int nReferences;
+  };
+
+  // Renderers only ever see a handful of distinct tilesets, so a linear scan
+  // is cheaper than hashing.
+  std::list<Entry> m_entries = {};
+
+  // Copies of a Texture share their pixels, so tilesets are the same if they
+  // split the same pixels into tiles the same way.
+  [[nodiscard]] static bool sameTileset(const Tileset &a,
+                                        const Tileset &b) noexcept {
+    const auto aTileSize = a.tileSize();
+    const auto bTileSize = b.tileSize();
+    const auto aDims = a.dimensions();
+    const auto bDims = b.dimensions();
+    return a.texture().asBytes().data() == b.texture().asBytes().data() &&
+           aTileSize.nColumns == bTileSize.nColumns &&
+           aTileSize.nRows == bTileSize.nRows &&
+           aDims.nColumns == bDims.nColumns && aDims.nRows == bDims.nRows &&
+           sameAnimations(a.animations(), b.animations());
+  }
+
+  [[nodiscard]] static bool
+  sameAnimations(const std::vector<TileAnimation> &a,
+                 const std::vector<TileAnimation> &b) noexcept {
+    const auto sameTile = [](const mata::core::Index2d &aTile,
+                             const mata::core::Index2d &bTile) {
+      return aTile.i == bTile.i && aTile.j == bTile.j;
+    };
+    return std::equal(
+        a.begin(), a.end(), b.begin(), b.end(),
+        [&sameTile](const TileAnimation &aAnim, const TileAnimation &bAnim) {
+          return sameTile(aAnim.tile, bAnim.tile) &&
+                 std::equal(aAnim.frames.begin(), aAnim.frames.end(),
+                            bAnim.frames.begin(), bAnim.frames.end(),
+                            [&sameTile](const TileAnimationFrame &aFrame,
+                                        const TileAnimationFrame &bFrame) {
+                              return sameTile(aFrame.tile, bFrame.tile) &&
+                                     aFrame.duration == bFrame.duration;
+                            });
+        });
+  }
+
+public:
+  template <typename F>
+  [[nodiscard]] TilesetH acquire(const Tileset &tileset, F &&upload) {
+    for (auto &entry : m_entries) {
+      if (sameTileset(entry.tileset, tileset)) {
+        entry.nReferences++;
+        return entry.handles;
+      }
+    }
+
+    const auto handles = upload(tileset);
+    m_entries.push_back(Entry{tileset, handles, 1});
+    return handles;
+  }
+
+  void release(const texture_h texture) noexcept {
+    for (auto &entry : m_entries) {
+      if (entry.handles.texture == texture) {
+        assert(entry.nReferences > 0);
+        entry.nReferences--;
+        return;
+      }
+    }
+  }
+
+  // Delete the textures of tilesets no longer used by any layer, returning
+  // how many were deleted.
+  std::size_t evictUnused(GlState &state) {
+    auto nEvicted = std::size_t{0};
+    for (auto iter = m_entries.begin(); iter != m_entries.end();) {
+      if (iter->nReferences == 0) {
+        state.deleteTexture(iter->handles.texture);
+        state.deleteTexture(iter->handles.animations);
+        glDeleteBuffers(1, &iter->handles.animationBuffer);
+        iter = m_entries.erase(iter);
+        nEvicted++;
+      } else {
+        ++iter;
+      }
+    }
+    return nEvicted;
+  }
+};
+
+// A draw submitted for the current frame. Commands are sorted by their state
+// so that consecutive draws share as much bound state as possible.
+struct DrawCommand {
+  // Tile layers are drawn back to front without a depth buffer, so the
+  // order a command is submitted in always wins over its state.
+  Renderer::LayerIdx order;
+  bool blend;
+  shaderprogram_h program;
   texture_h texture;
+  texture_h animations;
+  texture_h tileGrid;
+  buffer_h vertexArray;
+  GLsizei nVertices;
+  GLsizei nInstances;
+
+  [[nodiscard]] bool operator<(const DrawCommand &other) const noexcept {
+    return std::tie(order, blend, program, texture, animations, tileGrid,
+                    vertexArray) <
+           std::tie(other.order, other.blend, other.program, other.texture,
+                    other.animations, other.tileGrid, other.vertexArray);
+  }
+};
+
+// Uniform locations are looked up once when a program is linked.
+struct MeshProgram {
+  shaderprogram_h program;
+  GLint viewMatrix;
+  GLint time;
 };
 
+struct SpriteProgram {
+  shaderprogram_h program;
+  GLint viewMatrix;
+  GLint alphaCutoff;
+};
+
+struct TileMapProgram {
+  shaderprogram_h program;
+  GLint inverseViewMatrix;
+  GLint viewportSize;
+  GLint time;
+};
+
+// The vertex shader places tile (i, j) at (i, -j, 1) and applies the view
+// matrix without any projection, so the visible area of the map is whatever
+// the view maps into the [-1, 1] clip square. We invert the 2d affine part of
+// the view matrix to find the tile space bounds of that square.
+[[nodiscard]] inline std::optional<TileBounds>
+visibleTileBounds(const glm::mat4 &viewMatrix) noexcept {
+  const auto a = viewMatrix[0][0];
+  const auto b = viewMatrix[1][0];
+  const auto c = viewMatrix[0][1];
+  const auto d = viewMatrix[1][1];
+  const auto translation = glm::vec2(viewMatrix[2][0] + viewMatrix[3][0],
+                                     viewMatrix[2][1] + viewMatrix[3][1]);
+  const auto determinant = a * d - b * c;
+  if (std::abs(determinant) < std::numeric_limits<float>::epsilon()) {
+    return std::nullopt;
+  }
+
+  auto bounds = TileBounds{glm::vec2(std::numeric_limits<float>::max()),
+                           glm::vec2(std::numeric_limits<float>::lowest())};
+  for (const auto &corner : {glm::vec2(-1.0f, -1.0f), glm::vec2(-1.0f, 1.0f),
+                             glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 1.0f)}) {
+    const auto clip = corner - translation;
+    const auto x = (d * clip.x - b * clip.y) / determinant;
+    const auto y = (a * clip.y - c * clip.x) / determinant;
+    const auto tile = glm::vec2(x, -y);
+    bounds.min = glm::min(bounds.min, tile);
+    bounds.max = glm::max(bounds.max, tile);
+  }
+  return bounds;
+}
+
 class Renderer::Impl final {
   std::shared_ptr<mata::platform::VirtualFileSystem> m_pVfs;
-  shaderprogram_h m_hShaderProgram{0};
+  MeshProgram m_meshProgram{};
+  TileMapProgram m_tileMapProgram{};
+  SpriteProgram m_spriteProgram{};
+  buffer_h m_hQuadBuffer{0};
+  buffer_h m_hEmptyVao{0};
+  buffer_h m_hSpriteVao{0};
   bool m_wireframeModeEnabled = false;
   std::vector<LayerH> m_layers{};
+  TilesetCache m_tilesetCache{};
+  GlState m_glState{};
+  std::vector<DrawCommand> m_drawCommands{};
+  FrameStats m_frameStats{};
+  glm::mat4 m_viewMatrix = glm::mat4(1.0f);
+  glm::vec2 m_viewportSize{0.0f, 0.0f};
+  std::chrono::milliseconds m_animationTime{0};
+  // The view, viewport and time last uploaded to the programs' uniforms.
+  std::optional<glm::mat4> m_uploadedViewMatrix{};
+  std::optional<glm::vec2> m_uploadedViewportSize{};
+  std::optional<GLint> m_uploadedAnimationTime{};
+  GlErrorCheckMode m_errorCheckMode;
+  bool m_supportsS3tc = false;
+  bool m_tilesetMipmaps;
+  // Heap allocated so the debug message callback can keep a pointer to it.
+  std::unique_ptr<GlErrorLog> m_pErrorLog = std::make_unique<GlErrorLog>();
+  // Staging for per-frame uploads, created once GL is initialized.
+  std::unique_ptr<StreamBuffer> m_pStreamBuffer{};
+  std::shared_ptr<Profiler> m_pProfiler;
+  // Only exists while profiling.
+  std::unique_ptr<GpuTimer> m_pGpuTimer{};
+
+  // Sprites submitted for the next frame, and the tileset textures they
+  // hold a reference to until it's drawn.
+  struct QueuedSprite {
+    texture_h texture;
+    bool translucent;
+    SpriteInstance instance;
+  };
+  std::vector<QueuedSprite> m_sprites{};
+  std::vector<texture_h> m_spriteTextures{};
 
   void clearScreen() {
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-    glClear(ClearBufferMask::GL_COLOR_BUFFER_BIT);
+    // Only sprites are depth tested, so the depth buffer is left alone on
+    // frames without them. Clearing it needs depth writes on.
+    if (m_sprites.empty()) {
+      glClear(ClearBufferMask::GL_COLOR_BUFFER_BIT);
+    } else {
+      m_glState.setDepthWrite(true);
+      glClear(ClearBufferMask::GL_COLOR_BUFFER_BIT |
+              ClearBufferMask::GL_DEPTH_BUFFER_BIT);
+    }
   }
 
-  [[nodiscard]] shaderprogram_h initShaderProgram() {
+  [[nodiscard]] shaderprogram_h
+  initShaderProgram(const std::filesystem::path &vertexShaderPath,
+                    const std::filesystem::path &fragmentShaderPath) {
     const auto hVertexShader =
-        this->loadShader("default.vert", GL_VERTEX_SHADER);
+        this->loadShader(vertexShaderPath, GL_VERTEX_SHADER);
     const auto hFragmentShader =
-        this->loadShader("default.frag", GL_FRAGMENT_SHADER);
+        this->loadShader(fragmentShaderPath, GL_FRAGMENT_SHADER);
     const auto hShaderProgram = glCreateProgram();
     glAttachShader(hShaderProgram, hVertexShader);
     glAttachShader(hShaderProgram, hFragmentShader);
@@ -177,6 +670,54 @@ class Renderer::Impl final {
     return hShaderProgram;
   }
 
+  // Read a shader, replacing each #include "name" line, which GLSL doesn't
+  // have, with the named shader source. tile_id.glsl is generated from
+  // TileId, so that the shaders decode tile ids the same way it packs them.
+  [[nodiscard]] std::string
+  readShaderSource(const std::filesystem::path &shaderPath) {
+    if (shaderPath == "tile_id.glsl") {
+      return fmt::format("const uint FLIP_HORIZONTAL = {0}u;\n"
+                         "const uint FLIP_VERTICAL = {1}u;\n"
+                         "const uint FLIP_DIAGONAL = {2}u;\n"
+                         "const uint TILE_INDEX_MASK = {3}u;\n"
+                         "const uint EMPTY_TILE_INDEX = {4}u;\n",
+                         TileId::FLIP_HORIZONTAL, TileId::FLIP_VERTICAL,
+                         TileId::FLIP_DIAGONAL, TileId::MAX_INDEX + 1,
+                         TileId::empty().index());
+    }
+
+    // Shaders are small and shared between programs, so they're read through
+    // the VFS cache.
+    const auto pShaderSrc =
+        this->m_pVfs->readSharedFile("shaders" / shaderPath);
+    const auto source =
+        std::string_view(reinterpret_cast<const char *>(pShaderSrc->data()),
+                         pShaderSrc->size());
+    static constexpr auto INCLUDE = std::string_view("#include \"");
+    auto expanded = std::string{};
+    auto lineStart = std::size_t{0};
+    while (lineStart < source.size()) {
+      const auto newline = source.find('\n', lineStart);
+      const auto lineEnd =
+          newline == std::string_view::npos ? source.size() : newline + 1;
+      const auto line = source.substr(lineStart, lineEnd - lineStart);
+      if (line.substr(0, INCLUDE.size()) == INCLUDE) {
+        const auto nameEnd = line.find('"', INCLUDE.size());
+        if (nameEnd == std::string_view::npos) {
+          throw std::runtime_error(fmt::format(
+              "Malformed #include in shader {0}", shaderPath.string()));
+        }
+        expanded += this->readShaderSource(
+            line.substr(INCLUDE.size(), nameEnd - INCLUDE.size()));
+        expanded += '\n';
+      } else {
+        expanded += line;
+      }
+      lineStart = lineEnd;
+    }
+    return expanded;
+  }
+
   [[nodiscard]] shader_h loadShader(const std::filesystem::path &shaderPath,
                                     const GLenum shaderType) {
     const shader_h hShader = glCreateShader(shaderType);
@@ -184,10 +725,11 @@ class Renderer::Impl final {
       throw std::runtime_error("Failed to create shader object");
     }
 
-    const std::string shaderSrc =
-        this->m_pVfs->readTextFile("shaders" / shaderPath);
-    const char *shaderSrcCstr = shaderSrc.c_str();
-    glShaderSource(hShader, 1, &shaderSrcCstr, nullptr);
+    const auto shaderSrc = this->readShaderSource(shaderPath);
+    // The source isn't null terminated, so pass its length.
+    const auto shaderSrcChars = shaderSrc.data();
+    const auto shaderSrcLength = static_cast<GLint>(shaderSrc.size());
+    glShaderSource(hShader, 1, &shaderSrcChars, &shaderSrcLength);
     glCompileShader(hShader);
     int success;
     glGetShaderiv(hShader, GL_COMPILE_STATUS, &success);
@@ -201,156 +743,965 @@ class Renderer::Impl final {
     return hShader;
   }
 
-  [[nodiscard]] buffer_h createVertexBuffers(const TileLayerMesh &mesh) {
+  [[nodiscard]] buffer_h createQuadBuffer() {
+    buffer_h vbo;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(UNIT_QUAD), UNIT_QUAD, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return vbo;
+  }
+
+  [[nodiscard]] buffer_h
+  createInstanceBuffer(const std::vector<TileInstance> &instances) {
+    // The instance buffer holds the dynamic grid position and tile id of
+    // every tile in the layer.
+    buffer_h ibo;
+    glGenBuffers(1, &ibo);
+    glBindBuffer(GL_ARRAY_BUFFER, ibo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(instances.size() *
+                                         sizeof(TileInstance)),
+                 instances.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return ibo;
+  }
+
+  [[nodiscard]] buffer_h createVertexBuffers(const buffer_h instanceBuffer,
+                                             const std::size_t firstInstance) {
     buffer_h vao;
     glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    m_glState.bindVertexArray(vao);
 
     // =========================================================================
-    // Vertex Buffer
+    // Quad Vertex Buffer
     //
-    // We have one vertex buffer object (vbo) for all of the static,
-    // unchanging vertex attributes, including position and texture coords.
-    buffer_h vbo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    const auto vertices = mesh.vertices();
-    const auto nVertexCoords = vertices.size();
-    glBufferData(GL_ARRAY_BUFFER, nVertexCoords * sizeof(Vertex),
-                 vertices.data(), GL_STATIC_DRAW);
-
-    static const auto vertexPosAttribSize = sizeof(Vertex::PositionType);
-    static const auto textureCoordAttribSize =
-        sizeof(Vertex::TextureCoordsType);
-    static const auto vertexStride =
-        vertexPosAttribSize + textureCoordAttribSize;
-
-    // Add position vertex attribute.
-    static const auto vertexPosAttrib = 0;
-    glVertexAttribPointer(vertexPosAttrib, 2, GL_FLOAT, GL_FALSE, vertexStride,
-                          nullptr);
-    glEnableVertexAttribArray(vertexPosAttrib);
+    // Every chunk shares the same unit quad vertex buffer object (vbo).
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_hQuadBuffer);
 
-    // Map the textureCoords vertex attribute to the tbo.
-    static const auto textureCoordsAttrib = 1;
-    glVertexAttribPointer(textureCoordsAttrib, 2, GL_FLOAT, GL_FALSE,
-                          vertexStride, nullptr);
-    glEnableVertexAttribArray(textureCoordsAttrib);
+    static const auto quadVertexStride = sizeof(QuadVertex);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // Add corner vertex attribute.
+    static const auto cornerAttrib = 0;
+    glVertexAttribPointer(cornerAttrib, 2, GL_FLOAT, GL_FALSE, quadVertexStride,
+                          nullptr);
+    glEnableVertexAttribArray(cornerAttrib);
 
     // =========================================================================
-    // Tile Index Buffer
+    // Tile Instance Buffer
     //
-    // The tile index buffer (tibo) holds the dynamic id of the tile to render
-    // for a particular triangle/quad.
-    buffer_h tibo;
-    glGenBuffers(1, &tibo);
-    glBindBuffer(GL_ARRAY_BUFFER, tibo);
-    const auto tileIndexes = mesh.tileIndices();
-    const auto nTileIndexes = vertices.size();
-    glBufferData(GL_ARRAY_BUFFER, nTileIndexes * sizeof(int),
-                 tileIndexes.data(), GL_DYNAMIC_DRAW);
-
-    static const auto tileIndexAttribSize = sizeof(int);
-    static const auto tiboStride = tileIndexAttribSize;
-
-    // Map the textureCoords vertex attribute to the tbo.
-    static const auto tileIndexAttrib = 2;
-    glVertexAttribPointer(tileIndexAttrib, 1, GL_FLOAT, GL_FALSE, tiboStride,
-                          nullptr);
-    glEnableVertexAttribArray(tileIndexAttrib);
+    // Each chunk reads its own range of the layer's instance buffer, since
+    // GL 3.3 can't offset the instance id of glDrawArraysInstanced.
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+    static const auto instanceStride = sizeof(TileInstance);
+    const auto instanceOffset = firstInstance * instanceStride;
+
+    // Map the packed grid position instance attribute to the ibo.
+    static const auto gridPositionAttrib = 1;
+    glVertexAttribIPointer(
+        gridPositionAttrib, 2, GL_UNSIGNED_SHORT, instanceStride,
+        reinterpret_cast<const void *>(instanceOffset +
+                                       offsetof(TileInstance, i)));
+    glVertexAttribDivisor(gridPositionAttrib, 1);
+    glEnableVertexAttribArray(gridPositionAttrib);
+
+    // Map the packed tile id instance attribute to the ibo.
+    static const auto tileAttrib = 2;
+    glVertexAttribIPointer(
+        tileAttrib, 1, GL_UNSIGNED_INT, instanceStride,
+        reinterpret_cast<const void *>(instanceOffset +
+                                       offsetof(TileInstance, tile)));
+    glVertexAttribDivisor(tileAttrib, 1);
+    glEnableVertexAttribArray(tileAttrib);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     // Finish working on the vertex array.
-    glBindVertexArray(0);
+    m_glState.bindVertexArray(0);
 
     return vao;
   }
 
-  [[nodiscard]] texture_h uploadTileset(const Tileset &tileset) {
+  [[nodiscard]] buffer_h createSpriteVertexArray() {
+    buffer_h vao;
+    glGenVertexArrays(1, &vao);
+    m_glState.bindVertexArray(vao);
+
+    // Sprites share the unit quad with tile layers.
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_hQuadBuffer);
+    static const auto cornerAttrib = 0;
+    glVertexAttribPointer(cornerAttrib, 2, GL_FLOAT, GL_FALSE,
+                          sizeof(QuadVertex), nullptr);
+    glEnableVertexAttribArray(cornerAttrib);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // The instance attributes point into the stream buffer, at wherever each
+    // batch was written, so they're set for every batch when it's drawn.
+    for (const auto attrib : {1u, 2u, 3u, 4u, 5u}) {
+      glVertexAttribDivisor(attrib, 1);
+      glEnableVertexAttribArray(attrib);
+    }
+
+    m_glState.bindVertexArray(0);
+    return vao;
+  }
+
+  // Point the sprite vertex array's instance attributes at the instances
+  // starting at offset into the stream buffer, which must be bound.
+  void pointSpriteInstances(const std::size_t offset) {
+    static const auto stride = static_cast<GLsizei>(sizeof(SpriteInstance));
+    const auto at = [offset](const std::size_t memberOffset) {
+      return reinterpret_cast<const void *>(offset + memberOffset);
+    };
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride,
+                          at(offsetof(SpriteInstance, position)));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+                          at(offsetof(SpriteInstance, size)));
+    glVertexAttribIPointer(3, 1, GL_INT, stride,
+                           at(offsetof(SpriteInstance, tileIndex)));
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride,
+                          at(offsetof(SpriteInstance, depth)));
+    glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          at(offsetof(SpriteInstance, tint)));
+  }
+
+  static GLenum compressedInternalFormat(const TextureFormat format) noexcept {
+    return format == TextureFormat::Bc1 ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+                                        : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+  }
+
+  // Drivers can't generate mipmaps for compressed textures, so the levels are
+  // downsampled and compressed again on the CPU. The chain stops at the last
+  // level that's still a whole number of blocks.
+  void uploadCompressedMipLevels(const TextureFormat format,
+                                 const mata::core::bytes_view layers,
+                                 mata::core::GridDimensions2d levelSize,
+                                 const int nTiles) {
+    auto rgba = decompressBlocks(
+        format, layers, {levelSize.nColumns, levelSize.nRows * nTiles});
+    auto level = 0;
+    while (levelSize.nColumns % (2 * BLOCK_SIZE) == 0 &&
+           levelSize.nRows % (2 * BLOCK_SIZE) == 0) {
+      rgba = downsampleLayers(rgba, levelSize, nTiles);
+      levelSize = mipLevelSize(levelSize);
+      level++;
+      const auto blocks = compressBlocks(
+          format, rgba, {levelSize.nColumns, levelSize.nRows * nTiles});
+      glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level,
+                             compressedInternalFormat(format),
+                             levelSize.nColumns, levelSize.nRows, nTiles, 0,
+                             static_cast<GLsizei>(blocks.size()),
+                             blocks.data());
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, level);
+  }
+
+  [[nodiscard]] texture_h uploadTilesetTexture(const Tileset &tileset) {
     texture_h glTexture;
     glGenTextures(1, &glTexture);
 
-    glBindTexture(GL_TEXTURE_2D_ARRAY, glTexture);
+    m_glState.bindTexture(GL_TEXTURE_2D_ARRAY, glTexture);
 
     const auto tilesetDims = tileset.dimensions();
     const auto nTiles = tilesetDims.nColumns * tilesetDims.nRows;
     const auto tileSize = tileset.tileSize();
+    const auto format = tileset.texture().format();
+    const auto layers = tileset.asLinearBytes();
+
+    if (format == TextureFormat::Rgba8) {
+      glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, tileSize.nColumns,
+                   tileSize.nRows, nTiles, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                   layers.data());
+      if (m_tilesetMipmaps) {
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+      }
+    } else if (m_supportsS3tc) {
+      glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, 0,
+                             compressedInternalFormat(format),
+                             tileSize.nColumns, tileSize.nRows, nTiles, 0,
+                             static_cast<GLsizei>(layers.size()),
+                             layers.data());
+      if (m_tilesetMipmaps) {
+        uploadCompressedMipLevels(format, layers, tileSize, nTiles);
+      }
+    } else {
+      // Without S3TC the layers are decompressed on the CPU, which costs the
+      // memory savings but keeps compressed tilesets usable everywhere.
+      const auto rgba = decompressBlocks(
+          format, layers, {tileSize.nColumns, tileSize.nRows * nTiles});
+      glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, tileSize.nColumns,
+                   tileSize.nRows, nTiles, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                   rgba.data());
+      if (m_tilesetMipmaps) {
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+      }
+    }
 
-    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, tileSize.nColumns,
-                 tileSize.nRows, nTiles, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                 tileset.asLinearBytes().data());
-
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    // Each tile is its own layer and is sampled from its own mip chain, so
+    // clamping to the tile's edge is all the padding needed to keep filtered
+    // samples from wrapping around to the opposite edge.
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                    m_tilesetMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_R, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (!m_tilesetMipmaps) {
+      glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+
+    return glTexture;
+  }
 
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  // Every tileset gets an animation table, even an empty one, so that the
+  // tile shaders never sample an unbound buffer texture.
+  [[nodiscard]] TilesetH uploadTileset(const Tileset &tileset) {
+    const auto table = tileAnimationTable(tileset);
+    buffer_h buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER,
+                 static_cast<GLsizeiptr>(table.size() * sizeof(table[0])),
+                 table.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    texture_h animations;
+    glGenTextures(1, &animations);
+    m_glState.bindTexture(GL_TEXTURE_BUFFER, animations);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32I, buffer);
+
+    return {uploadTilesetTexture(tileset), animations, buffer};
+  }
+
+  [[nodiscard]] texture_h
+  uploadTileGrid(const TileLayer &layer,
+                 std::vector<TileGridIndex> &tileIndices) {
+    const auto dimensions = layer.dimensions();
+    tileIndices.clear();
+    tileIndices.reserve(
+        static_cast<std::size_t>(dimensions.nColumns * dimensions.nRows));
+    for (auto j = 0; j < dimensions.nRows; j++) {
+      for (auto i = 0; i < dimensions.nColumns; i++) {
+        tileIndices.push_back(layer.tileAt({i, j}).value());
+      }
+    }
+
+    texture_h glTexture;
+    glGenTextures(1, &glTexture);
+    m_glState.bindTexture(GL_TEXTURE_2D, glTexture);
+
+    // Rows of 16-bit indices are only 2 byte aligned.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignof(TileGridIndex));
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, dimensions.nColumns,
+                 dimensions.nRows, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT,
+                 tileIndices.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Integer textures can't be filtered, and the shader only uses texelFetch.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
 
     return glTexture;
   }
 
-public:
-  Impl(const Window &window,
-       const std::shared_ptr<mata::platform::VirtualFileSystem> _pVfs)
-      : m_pVfs(_pVfs) {
-    glbinding::initialize(window.glProcAddressFunc());
-    glbinding::setAfterCallback(
-        []([[maybe_unused]] const glbinding::FunctionCall &functionCall) {
-          const auto errorCode = glbinding::Binding::GetError.directCall();
+  [[nodiscard]] LayerH createMeshLayer(const TileLayer &layer) {
+    auto mesh = TileLayerMesh(layer);
+    const auto instanceBuffer = createInstanceBuffer(mesh.instances());
+    auto chunks = std::vector<ChunkH>{};
+    chunks.reserve(mesh.chunks().size());
+    for (const auto &chunk : mesh.chunks()) {
+      const auto vao = createVertexBuffers(instanceBuffer, chunk.firstInstance);
+      chunks.push_back(
+          {vao, chunk.firstInstance, chunk.nInstances, chunk.bounds});
+    }
+
+    auto layerH = LayerH{};
+    layerH.mode = LayerRenderMode::Mesh;
+    layerH.nChunks = mesh.nChunks();
+    layerH.chunks = std::move(chunks);
+    layerH.instanceBuffer = instanceBuffer;
+    layerH.chunkInstances.reserve(mesh.chunks().size());
+    for (const auto &chunk : mesh.chunks()) {
+      const auto first = mesh.instances().begin() +
+                         static_cast<std::ptrdiff_t>(chunk.firstInstance);
+      layerH.chunkInstances.emplace_back(first, first + chunk.nInstances);
+    }
+    return layerH;
+  }
+
+  [[nodiscard]] LayerH createTileMapLayer(const TileLayer &layer) {
+    auto layerH = LayerH{};
+    layerH.mode = LayerRenderMode::TileMap;
+    layerH.tileGrid = uploadTileGrid(layer, layerH.tileGridIndices);
+    return layerH;
+  }
+
+  void releaseLayer(LayerH &layer) {
+    for (const auto &chunk : layer.chunks) {
+      m_glState.deleteVertexArray(chunk.vao);
+    }
+    if (layer.instanceBuffer != 0) {
+      glDeleteBuffers(1, &layer.instanceBuffer);
+    }
+    if (layer.tileGrid != 0) {
+      m_glState.deleteTexture(layer.tileGrid);
+    }
+    if (layer.texture != 0) {
+      m_tilesetCache.release(layer.texture);
+    }
+    layer = LayerH{};
+  }
+
+  [[nodiscard]] LayerH &layerAt(const LayerIdx layerN) {
+    if (layerN >= this->m_layers.size()) {
+      throw std::logic_error(fmt::format("no layer at index {0}", layerN));
+    }
+    return this->m_layers[layerN];
+  }
+
+  // Lay a mesh layer's chunks out again and upload all of its instances,
+  // after edits added or removed some. Frames still drawing from the old
+  // buffer keep it alive until they're done.
+  void rebuildInstanceBuffer(LayerH &layer) {
+    auto instances = std::vector<TileInstance>{};
+    for (auto chunkN = std::size_t{0}; chunkN < layer.chunks.size();
+         chunkN++) {
+      const auto &chunkInstances = layer.chunkInstances[chunkN];
+      auto &chunk = layer.chunks[chunkN];
+      chunk.firstInstance = instances.size();
+      chunk.nInstances = static_cast<int>(chunkInstances.size());
+      instances.insert(instances.end(), chunkInstances.begin(),
+                       chunkInstances.end());
+    }
+
+    for (const auto &chunk : layer.chunks) {
+      m_glState.deleteVertexArray(chunk.vao);
+    }
+    glDeleteBuffers(1, &layer.instanceBuffer);
+
+    layer.instanceBuffer = createInstanceBuffer(instances);
+    for (auto &chunk : layer.chunks) {
+      chunk.vao =
+          createVertexBuffers(layer.instanceBuffer, chunk.firstInstance);
+    }
+    layer.instancesMoved = false;
+    layer.dirtyInstances = DirtyRanges{};
+  }
 
-          if (errorCode == gl::GL_NO_ERROR) {
-            return;
-          }
+  // Edit a mesh layer tile, adding or removing its instance if it changes
+  // between empty and not. Either only marks the layer's instances as moved;
+  // the chunks are laid out again once, when the edits are flushed.
+  void setMeshTile(LayerH &layer, const mata::core::Index2d &index,
+                   const TileId tile) {
+    const auto chunkN = static_cast<std::size_t>(mata::core::index2dTo1d(
+        {index.i / CHUNK_SIZE, index.j / CHUNK_SIZE}, layer.nChunks));
+    auto &instances = layer.chunkInstances[chunkN];
+    const auto instance = std::find_if(
+        instances.begin(), instances.end(),
+        [&index](const TileInstance &candidate) {
+          return candidate.i == index.i && candidate.j == index.j;
+        });
 
-          if (errorCode == GL_OUT_OF_MEMORY) {
-            throw std::runtime_error("OpenGL driver reported out of memory");
-          }
+    if (instance != instances.end() && !tile.isEmpty()) {
+      instance->tile = tile.value();
+      // Once instances have moved, the chunks' offsets are stale, and the
+      // whole buffer is uploaded anyway.
+      if (!layer.instancesMoved) {
+        const auto instanceN =
+            layer.chunks[chunkN].firstInstance +
+            static_cast<std::size_t>(instance - instances.begin());
+        layer.dirtyInstances.add(instanceN, instanceN + 1);
+      }
+      return;
+    }
+    if (instance == instances.end() && tile.isEmpty()) {
+      return;
+    }
+
+    if (instance != instances.end()) {
+      *instance = instances.back();
+      instances.pop_back();
+    } else {
+      instances.push_back(
+          {static_cast<TileInstance::GridPositionType>(index.i),
+           static_cast<TileInstance::GridPositionType>(index.j),
+           tile.value()});
+    }
+    layer.instancesMoved = true;
+  }
+
+  // Copy a range of a mesh layer's instance buffer out of its chunks.
+  static void copyInstances(const LayerH &layer, const std::size_t begin,
+                            const std::size_t end, TileInstance *pOut) {
+    // The last chunk starting at or before begin holds it; empty chunks
+    // before it start at the same instance.
+    auto chunk = std::upper_bound(layer.chunks.begin(), layer.chunks.end(),
+                                  begin,
+                                  [](const std::size_t instanceN,
+                                     const ChunkH &candidate) {
+                                    return instanceN < candidate.firstInstance;
+                                  }) -
+                 1;
+    auto instanceN = begin;
+    while (instanceN < end) {
+      const auto &instances = layer.chunkInstances[static_cast<std::size_t>(
+          chunk - layer.chunks.begin())];
+      const auto offset = instanceN - chunk->firstInstance;
+      const auto n = std::min(end - instanceN, instances.size() - offset);
+      std::copy_n(instances.begin() + static_cast<std::ptrdiff_t>(offset), n,
+                  pOut);
+      pOut += n;
+      instanceN += n;
+      ++chunk;
+    }
+  }
+
+  // Upload the tiles edited since the last frame. Edits are written to the
+  // stream buffer and copied on the GPU, since updating buffers and textures
+  // that earlier frames are still drawing from directly would stall.
+  void flushDirtyTiles() {
+    for (auto &layer : this->m_layers) {
+      if (layer.instancesMoved) {
+        rebuildInstanceBuffer(layer);
+      } else if (!layer.dirtyInstances.empty()) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, layer.instanceBuffer);
+        layer.dirtyInstances.flush(
+            [this, &layer](const std::size_t begin, const std::size_t end) {
+              const auto size = (end - begin) * sizeof(TileInstance);
+              const auto allocation =
+                  m_pStreamBuffer->map(size, alignof(TileInstance));
+              copyInstances(
+                  layer, begin, end,
+                  reinterpret_cast<TileInstance *>(allocation.pData));
+              m_pStreamBuffer->unmap();
+              glBindBuffer(GL_COPY_READ_BUFFER, m_pStreamBuffer->buffer());
+              glCopyBufferSubData(
+                  GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                  static_cast<GLintptr>(allocation.offset),
+                  static_cast<GLintptr>(begin * sizeof(TileInstance)),
+                  static_cast<GLsizeiptr>(size));
+            });
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+      }
+
+      if (layer.dirtyTileGrid) {
+        // Pack the edited rows together and unpack them from the stream
+        // buffer.
+        const auto &rect = *layer.dirtyTileGrid;
+        const auto width = rect.max.i - rect.min.i;
+        const auto height = rect.max.j - rect.min.j;
+        const auto rowSize =
+            static_cast<std::size_t>(width) * sizeof(TileGridIndex);
+        const auto allocation = m_pStreamBuffer->map(
+            rowSize * static_cast<std::size_t>(height), alignof(TileGridIndex));
+        for (auto row = 0; row < height; row++) {
+          const auto first = static_cast<std::size_t>(mata::core::index2dTo1d(
+              {rect.min.i, rect.min.j + row}, layer.dimensions));
+          const auto pRow =
+              allocation.pData + static_cast<std::size_t>(row) * rowSize;
+          std::memcpy(pRow, layer.tileGridIndices.data() + first, rowSize);
+        }
+        m_pStreamBuffer->unmap();
+
+        m_glState.bindTexture(GL_TEXTURE_2D, layer.tileGrid);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pStreamBuffer->buffer());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignof(TileGridIndex));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.min.i, rect.min.j, width,
+                        height, GL_RED_INTEGER, GL_UNSIGNED_SHORT,
+                        reinterpret_cast<const void *>(allocation.offset));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        layer.dirtyTileGrid.reset();
+      }
+    }
+  }
+
+  void submitMeshLayer(const LayerIdx layerN, const LayerH &layer,
+                       const std::optional<TileBounds> &visibleBounds) {
+    if (layer.chunks.empty()) {
+      return;
+    }
+
+    // Only visit the chunks overlapping the visible bounds; if the view
+    // can't be inverted we fall back to drawing every chunk.
+    auto firstChunk = mata::core::Index2d{0, 0};
+    auto lastChunk = mata::core::Index2d{layer.nChunks.nColumns - 1,
+                                         layer.nChunks.nRows - 1};
+    if (visibleBounds) {
+      // Clamp before converting to int so that far away cameras can't
+      // overflow; chunks clamped into range are rejected by their bounds.
+      const auto chunkIndex = [](const float tile, const int nChunks) {
+        const auto chunk = std::floor(tile / static_cast<float>(CHUNK_SIZE));
+        return static_cast<int>(
+            std::clamp(chunk, 0.0f, static_cast<float>(nChunks - 1)));
+      };
+      firstChunk = {chunkIndex(visibleBounds->min.x, layer.nChunks.nColumns),
+                    chunkIndex(visibleBounds->min.y, layer.nChunks.nRows)};
+      lastChunk = {chunkIndex(visibleBounds->max.x, layer.nChunks.nColumns),
+                   chunkIndex(visibleBounds->max.y, layer.nChunks.nRows)};
+    }
+
+    auto nChunksDrawn = 0u;
+    for (auto chunkRow = firstChunk.j; chunkRow <= lastChunk.j; chunkRow++) {
+      for (auto chunkCol = firstChunk.i; chunkCol <= lastChunk.i; chunkCol++) {
+        const auto &chunk = layer.chunks[static_cast<std::size_t>(
+            mata::core::index2dTo1d({chunkCol, chunkRow}, layer.nChunks))];
+        if (chunk.nInstances == 0 ||
+            (visibleBounds && !chunk.bounds.overlaps(*visibleBounds))) {
+          continue;
+        }
+        m_drawCommands.push_back({layerN, false, m_meshProgram.program,
+                                  layer.texture, layer.animations, 0,
+                                  chunk.vao, N_QUAD_VERTICES,
+                                  chunk.nInstances});
+        nChunksDrawn++;
+      }
+    }
+    m_frameStats.chunksDrawn += nChunksDrawn;
+    m_frameStats.chunksCulled +=
+        static_cast<unsigned int>(layer.chunks.size()) - nChunksDrawn;
+  }
+
+  void submitTileMapLayer(const LayerIdx layerN, const LayerH &layer) {
+    m_drawCommands.push_back({layerN, false, m_tileMapProgram.program,
+                              layer.texture, layer.animations, layer.tileGrid,
+                              m_hEmptyVao, 3, 0});
+  }
+
+  void uploadViewUniforms() {
+    if (m_uploadedViewMatrix != m_viewMatrix) {
+      m_glState.useProgram(m_meshProgram.program);
+      glUniformMatrix4fv(m_meshProgram.viewMatrix, 1, GL_FALSE,
+                         glm::value_ptr(m_viewMatrix));
+      m_glState.useProgram(m_spriteProgram.program);
+      glUniformMatrix4fv(m_spriteProgram.viewMatrix, 1, GL_FALSE,
+                         glm::value_ptr(m_viewMatrix));
+      m_glState.useProgram(m_tileMapProgram.program);
+      glUniformMatrix4fv(m_tileMapProgram.inverseViewMatrix, 1, GL_FALSE,
+                         glm::value_ptr(glm::inverse(m_viewMatrix)));
+      m_uploadedViewMatrix = m_viewMatrix;
+      m_glState.countChange();
+    } else {
+      m_glState.countAvoided();
+    }
+
+    // The shaders loop animations with integer milliseconds, which wrap
+    // after 24 days.
+    const auto animationTime = static_cast<GLint>(
+        m_animationTime.count() % std::numeric_limits<GLint>::max());
+    if (m_uploadedAnimationTime != animationTime) {
+      m_glState.useProgram(m_meshProgram.program);
+      glUniform1i(m_meshProgram.time, animationTime);
+      m_glState.useProgram(m_tileMapProgram.program);
+      glUniform1i(m_tileMapProgram.time, animationTime);
+      m_uploadedAnimationTime = animationTime;
+      m_glState.countChange();
+    } else {
+      m_glState.countAvoided();
+    }
+
+    if (m_uploadedViewportSize != m_viewportSize) {
+      m_glState.useProgram(m_tileMapProgram.program);
+      glUniform2f(m_tileMapProgram.viewportSize, m_viewportSize.x,
+                  m_viewportSize.y);
+      m_uploadedViewportSize = m_viewportSize;
+      m_glState.countChange();
+    } else {
+      m_glState.countAvoided();
+    }
+  }
+
+  void executeDrawCommands() {
+    std::stable_sort(m_drawCommands.begin(), m_drawCommands.end());
+    for (const auto &command : m_drawCommands) {
+      m_glState.setBlend(command.blend);
+      m_glState.useProgram(command.program);
+      m_glState.bindTexture(0, GL_TEXTURE_2D_ARRAY, command.texture);
+      if (command.tileGrid != 0) {
+        m_glState.bindTexture(1, GL_TEXTURE_2D, command.tileGrid);
+      }
+      if (command.animations != 0) {
+        m_glState.bindTexture(2, GL_TEXTURE_BUFFER, command.animations);
+      }
+      m_glState.bindVertexArray(command.vertexArray);
+      if (command.nInstances > 0) {
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, command.nVertices,
+                              command.nInstances);
+      } else {
+        glDrawArrays(GL_TRIANGLES, 0, command.nVertices);
+      }
+    }
+    m_frameStats.drawCalls = static_cast<unsigned int>(m_drawCommands.size());
+    m_drawCommands.clear();
+  }
+
+  // Cut out sprites are drawn first, grouped by tileset and front to back
+  // within each so that the depth test rejects hidden fragments early. Then
+  // translucent sprites are blended back to front, which only batches
+  // neighbours in depth that share a tileset.
+  [[nodiscard]] static bool spriteDrawOrder(const QueuedSprite &a,
+                                            const QueuedSprite &b) noexcept {
+    if (a.translucent != b.translucent) {
+      return !a.translucent;
+    }
+    if (!a.translucent) {
+      return std::tie(a.texture, b.instance.depth) <
+             std::tie(b.texture, a.instance.depth);
+    }
+    return std::tie(a.instance.depth, a.texture) <
+           std::tie(b.instance.depth, b.texture);
+  }
+
+  void drawSprites(const std::optional<TileBounds> &visibleBounds) {
+    if (visibleBounds) {
+      const auto visibleEnd = std::remove_if(
+          m_sprites.begin(), m_sprites.end(),
+          [&visibleBounds](const QueuedSprite &sprite) {
+            const auto &instance = sprite.instance;
+            return !TileBounds{instance.position,
+                               instance.position + instance.size}
+                        .overlaps(*visibleBounds);
+          });
+      m_frameStats.spritesCulled =
+          static_cast<unsigned int>(m_sprites.end() - visibleEnd);
+      m_sprites.erase(visibleEnd, m_sprites.end());
+    }
+    if (m_sprites.empty()) {
+      return;
+    }
+    std::stable_sort(m_sprites.begin(), m_sprites.end(), spriteDrawOrder);
+
+    // Every sprite is written to the stream buffer at once, in draw order,
+    // and each batch draws a run of them.
+    const auto allocation = m_pStreamBuffer->map(
+        m_sprites.size() * sizeof(SpriteInstance), alignof(SpriteInstance));
+    for (auto i = std::size_t{0}; i < m_sprites.size(); i++) {
+      std::memcpy(allocation.pData + i * sizeof(SpriteInstance),
+                  &m_sprites[i].instance, sizeof(SpriteInstance));
+    }
+    m_pStreamBuffer->unmap();
+
+    m_glState.useProgram(m_spriteProgram.program);
+    m_glState.bindVertexArray(m_hSpriteVao);
+    m_glState.setDepthTest(true);
+    glBindBuffer(GL_ARRAY_BUFFER, m_pStreamBuffer->buffer());
+    auto nDrawCalls = 0u;
+    for (auto begin = std::size_t{0}; begin < m_sprites.size();) {
+      const auto &first = m_sprites[begin];
+      auto end = begin + 1;
+      while (end < m_sprites.size() &&
+             m_sprites[end].translucent == first.translucent &&
+             m_sprites[end].texture == first.texture) {
+        end++;
+      }
+
+      if (begin == 0 || first.translucent != m_sprites[begin - 1].translucent) {
+        m_glState.setBlend(first.translucent);
+        m_glState.setDepthWrite(!first.translucent);
+        glUniform1f(m_spriteProgram.alphaCutoff,
+                    first.translucent ? 0.0f : SPRITE_ALPHA_CUTOFF);
+        m_glState.countChange();
+      }
+      m_glState.bindTexture(0, GL_TEXTURE_2D_ARRAY, first.texture);
+      pointSpriteInstances(allocation.offset + begin * sizeof(SpriteInstance));
+      glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, N_QUAD_VERTICES,
+                            static_cast<GLsizei>(end - begin));
+      nDrawCalls++;
+      begin = end;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_glState.setDepthTest(false);
+
+    m_frameStats.drawCalls += nDrawCalls;
+    m_frameStats.spritesDrawn = static_cast<unsigned int>(m_sprites.size());
+  }
+
+  void releaseSprites() {
+    for (const auto texture : m_spriteTextures) {
+      m_tilesetCache.release(texture);
+    }
+    m_spriteTextures.clear();
+    m_sprites.clear();
+  }
+
+  void enableErrorChecks() {
+    if (m_errorCheckMode == GlErrorCheckMode::DebugOutput) {
+      const auto extensions = glbinding::aux::ContextInfo::extensions();
+      if (extensions.count(GLextension::GL_KHR_debug) == 0) {
+        m_errorCheckMode = GlErrorCheckMode::PerFrame;
+      }
+    }
+
+    switch (m_errorCheckMode) {
+    case GlErrorCheckMode::PerCall:
+      glbinding::setAfterCallback(
+          []([[maybe_unused]] const glbinding::FunctionCall &functionCall) {
+            const auto errorCode = glbinding::Binding::GetError.directCall();
+
+            if (errorCode == gl::GL_NO_ERROR) {
+              return;
+            }
+
+            if (errorCode == GL_OUT_OF_MEMORY) {
+              throw std::runtime_error("OpenGL driver reported out of memory");
+            }
 
 #ifndef NDEBUG
-          const auto message =
-              fmt::format("{0}: {1}", functionCall.function->name(),
-                          readableErrorCode(errorCode));
-          std::cerr << message << "\n";
-          std::terminate();
+            const auto message =
+                fmt::format("{0}: {1}", functionCall.function->name(),
+                            readableErrorCode(errorCode));
+            std::cerr << message << "\n";
+            std::terminate();
 #endif
-        });
-    glbinding::setCallbackMaskExcept(glbinding::CallbackMask::After,
-                                     {"glGetError"});
+          });
+      glbinding::setCallbackMaskExcept(glbinding::CallbackMask::After,
+                                       {"glGetError"});
+      break;
+    case GlErrorCheckMode::DebugOutput:
+      glEnable(GL_DEBUG_OUTPUT);
+#ifndef NDEBUG
+      // Report errors from inside the failing call so that they show up in
+      // its stack trace.
+      glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+      glDebugMessageCallback(handleGlDebugMessage, m_pErrorLog.get());
+      break;
+    case GlErrorCheckMode::PerFrame:
+      break;
+    }
+  }
 
-    this->m_hShaderProgram = this->initShaderProgram();
-    glUseProgram(this->m_hShaderProgram);
+  void disableErrorChecks() {
+    switch (m_errorCheckMode) {
+    case GlErrorCheckMode::PerCall:
+      glbinding::removeCallbackMaskExcept(glbinding::CallbackMask::After,
+                                          {"glGetError"});
+      break;
+    case GlErrorCheckMode::DebugOutput:
+      glDebugMessageCallback(nullptr, nullptr);
+      glDisable(GL_DEBUG_OUTPUT);
+      break;
+    case GlErrorCheckMode::PerFrame:
+      break;
+    }
+  }
+
+  void checkFrameErrors() {
+    if (m_errorCheckMode == GlErrorCheckMode::PerCall) {
+      return;
+    }
+    // The debug callback may not report out of memory errors, so the error
+    // flags are polled in both modes. That's one call per frame.
+    m_pErrorLog->poll();
+    m_pErrorLog->report("drawFrame");
+  }
+
+public:
+  Impl(const Window &window,
+       const std::shared_ptr<mata::platform::VirtualFileSystem> _pVfs,
+       const RendererParams &params)
+      : m_pVfs(_pVfs), m_errorCheckMode(params.errorCheckMode),
+        m_tilesetMipmaps(params.tilesetMipmaps),
+        m_pProfiler(params.pProfiler) {
+    glbinding::initialize(window.glProcAddressFunc());
+    this->enableErrorChecks();
+    const auto extensions = glbinding::aux::ContextInfo::extensions();
+    m_supportsS3tc =
+        extensions.count(GLextension::GL_EXT_texture_compression_s3tc) > 0;
+    m_pStreamBuffer = std::make_unique<StreamBuffer>(
+        STREAM_BUFFER_FRAME_CAPACITY,
+        extensions.count(GLextension::GL_ARB_buffer_storage) > 0);
+    if (m_pProfiler) {
+      m_pGpuTimer = std::make_unique<GpuTimer>(*m_pProfiler);
+    }
+
+    const auto meshProgram =
+        this->initShaderProgram("default.vert", "default.frag");
+    this->m_meshProgram = {meshProgram,
+                           glGetUniformLocation(meshProgram, "viewMatrix"),
+                           glGetUniformLocation(meshProgram, "uTimeMs")};
+    const auto tileMapProgram =
+        this->initShaderProgram("tilemap.vert", "tilemap.frag");
+    this->m_tileMapProgram = {
+        tileMapProgram,
+        glGetUniformLocation(tileMapProgram, "uInverseViewMatrix"),
+        glGetUniformLocation(tileMapProgram, "uViewportSize"),
+        glGetUniformLocation(tileMapProgram, "uTimeMs")};
+    const auto spriteProgram =
+        this->initShaderProgram("sprite.vert", "default.frag");
+    this->m_spriteProgram = {
+        spriteProgram, glGetUniformLocation(spriteProgram, "viewMatrix"),
+        glGetUniformLocation(spriteProgram, "uAlphaCutoff")};
+    m_glState.useProgram(meshProgram);
+    glUniform1f(glGetUniformLocation(meshProgram, "uAlphaCutoff"), 0.0f);
+    glUniform1i(glGetUniformLocation(meshProgram, "uTileAnimations"), 2);
+    m_glState.useProgram(tileMapProgram);
+    glUniform1i(glGetUniformLocation(tileMapProgram, "uTexture"), 0);
+    glUniform1i(glGetUniformLocation(tileMapProgram, "uTileGrid"), 1);
+    glUniform1i(glGetUniformLocation(tileMapProgram, "uTileAnimations"), 2);
+    this->m_hQuadBuffer = this->createQuadBuffer();
+    this->m_hSpriteVao = this->createSpriteVertexArray();
+    // Sprites at the same depth are drawn in order, and depth 0 is on the far
+    // plane that the depth buffer is cleared to.
+    glDepthFunc(GL_LEQUAL);
+    // Core profile requires a vertex array to be bound even when drawing
+    // without any vertex attributes.
+    glGenVertexArrays(1, &this->m_hEmptyVao);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    this->m_viewportSize = {static_cast<float>(viewport[2]),
+                            static_cast<float>(viewport[3])};
   }
 
   ~Impl() {
-    glbinding::removeCallbackMaskExcept(glbinding::CallbackMask::After,
-                                        {"glGetError"});
+    for (auto &layer : this->m_layers) {
+      releaseLayer(layer);
+    }
+    this->releaseSprites();
+    m_tilesetCache.evictUnused(m_glState);
+    this->disableErrorChecks();
+  }
+
+  void setLayer(const LayerIdx layerN, const TileLayer &layer,
+                const LayerRenderMode mode) {
+    const auto dimensions = layer.dimensions();
+    if (dimensions.nColumns > MAX_LAYER_SIZE ||
+        dimensions.nRows > MAX_LAYER_SIZE) {
+      throw std::logic_error(fmt::format(
+          "tile layer of {0}x{1} tiles exceeds the maximum size of {2}x{2}",
+          dimensions.nColumns, dimensions.nRows, MAX_LAYER_SIZE));
+    }
+
+    auto layerH = mode == LayerRenderMode::TileMap ? createTileMapLayer(layer)
+                                                   : createMeshLayer(layer);
+    layerH.bounds = {glm::vec2(0.0f, 0.0f),
+                     glm::vec2(static_cast<float>(dimensions.nColumns),
+                               static_cast<float>(dimensions.nRows))};
+    layerH.dimensions = dimensions;
+    layerH.tilesetDimensions = layer.tileset().dimensions();
+    const auto tilesetH = m_tilesetCache.acquire(
+        layer.tileset(),
+        [this](const Tileset &tileset) { return uploadTileset(tileset); });
+    layerH.texture = tilesetH.texture;
+    layerH.animations = tilesetH.animations;
+
+    if (layerN >= this->m_layers.size()) {
+      this->m_layers.resize(layerN + 1);
+    }
+    releaseLayer(this->m_layers[layerN]);
+    this->m_layers[layerN] = std::move(layerH);
+  }
+
+  void setTiles(const LayerIdx layerN, const mata::core::Index2d &origin,
+                const mata::core::GridDimensions2d &dimensions,
+                const std::vector<TileId> &tiles) {
+    auto &layer = layerAt(layerN);
+    const auto rect =
+        TileRect{origin, {origin.i + dimensions.nColumns,
+                          origin.j + dimensions.nRows}};
+    if (rect.min.i < 0 || rect.min.j < 0 ||
+        rect.max.i > layer.dimensions.nColumns ||
+        rect.max.j > layer.dimensions.nRows) {
+      throw std::logic_error(fmt::format(
+          "tiles ({0}, {1})..({2}, {3}) are outside of layer {4}", rect.min.i,
+          rect.min.j, rect.max.i, rect.max.j, layerN));
+    }
+    if (tiles.size() !=
+        static_cast<std::size_t>(dimensions.nColumns * dimensions.nRows)) {
+      throw std::logic_error(
+          fmt::format("expected {0} tiles but got {1}",
+                      dimensions.nColumns * dimensions.nRows, tiles.size()));
+    }
+    const auto nTilesetTiles =
+        layer.tilesetDimensions.nColumns * layer.tilesetDimensions.nRows;
+    for (const auto &tile : tiles) {
+      if (!tile.isEmpty() && tile.index() >= nTilesetTiles) {
+        throw std::logic_error(
+            fmt::format("tile {0} is outside of the tileset of layer {1}",
+                        tile.index(), layerN));
+      }
+    }
+
+    for (auto j = 0; j < dimensions.nRows; j++) {
+      for (auto i = 0; i < dimensions.nColumns; i++) {
+        const auto tile = tiles[static_cast<std::size_t>(
+            mata::core::index2dTo1d({i, j}, dimensions))];
+        const auto index = mata::core::Index2d{origin.i + i, origin.j + j};
+        if (layer.mode == LayerRenderMode::TileMap) {
+          layer.tileGridIndices[static_cast<std::size_t>(
+              mata::core::index2dTo1d(index, layer.dimensions))] =
+              tile.value();
+        } else {
+          setMeshTile(layer, index, tile);
+        }
+      }
+    }
+
+    if (layer.mode == LayerRenderMode::TileMap) {
+      if (layer.dirtyTileGrid) {
+        layer.dirtyTileGrid->extend(rect);
+      } else {
+        layer.dirtyTileGrid = rect;
+      }
+    }
   }
 
-  void setLayer(const LayerIdx layerN, const TileLayer &layer) {
-    const auto mesh = TileLayerMesh(layer);
-    const auto vao = createVertexBuffers(mesh);
-    const auto textureHandle = uploadTileset(layer.tileset());
+  void submitSprites(const Tileset &tileset,
+                     const std::vector<Sprite> &sprites) {
+    if (sprites.empty()) {
+      return;
+    }
+    const auto texture = m_tilesetCache
+                             .acquire(tileset,
+                                      [this](const Tileset &newTileset) {
+                                        return uploadTileset(newTileset);
+                                      })
+                             .texture;
+    m_spriteTextures.push_back(texture);
+
+    const auto tilesetDims = tileset.dimensions();
+    m_sprites.reserve(m_sprites.size() + sprites.size());
+    for (const auto &sprite : sprites) {
+      const auto toByte = [](const float channel) {
+        return static_cast<std::uint8_t>(
+            std::lround(std::clamp(channel, 0.0f, 1.0f) * 255.0f));
+      };
+      const auto tint = std::array<std::uint8_t, 4>{
+          toByte(sprite.tint.x), toByte(sprite.tint.y), toByte(sprite.tint.z),
+          toByte(sprite.tint.w)};
+      m_sprites.push_back(
+          {texture, tint[3] < 255,
+           {sprite.position, sprite.size,
+            mata::core::index2dTo1d(sprite.tile, tilesetDims), sprite.depth,
+            tint}});
+    }
+  }
 
-    const auto layerIter = this->m_layers.begin();
-    this->m_layers.insert(layerIter + layerN, {
-                                                  vao,
-                                                  mesh.nIndices(),
-                                                  textureHandle,
-                                              });
+  void useOnCurrentThread() {
+    // glbinding keeps the current context per thread; the one the
+    // constructor initialised is registered as context 0.
+    glbinding::useContext(0);
   }
 
   void updateCamera(const Camera &camera) noexcept {
-    const auto viewMatrix = camera.viewMatrix();
-    const auto transformLoc =
-        glGetUniformLocation(this->m_hShaderProgram, "viewMatrix");
-    glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+    this->m_viewMatrix = camera.viewMatrix();
+  }
+
+  void setAnimationTime(const std::chrono::milliseconds time) noexcept {
+    this->m_animationTime = time;
+  }
+
+  std::size_t evictUnusedTilesets() {
+    return m_tilesetCache.evictUnused(m_glState);
   }
 
+  FrameStats frameStats() const noexcept { return m_frameStats; }
+
+  GlErrorCheckMode errorCheckMode() const noexcept { return m_errorCheckMode; }
+
   void toggleWireframeMode() {
     m_wireframeModeEnabled = !m_wireframeModeEnabled;
     if (m_wireframeModeEnabled) {
@@ -361,42 +1712,117 @@ public:
   }
 
   void drawFrame() {
+    const auto frameScope = Profiler::Scope(m_pProfiler.get(), "draw frame");
+    if (m_pGpuTimer) {
+      m_pGpuTimer->beginFrame();
+    }
+    m_frameStats = {};
+    {
+      const auto scope = Profiler::Scope(m_pProfiler.get(), "tile upload");
+      const auto span = GpuTimer::Span(m_pGpuTimer.get(), "tile upload");
+      this->flushDirtyTiles();
+    }
     this->clearScreen();
-
-    glActiveTexture(GL_TEXTURE0);
-    for (const auto &layer : this->m_layers) {
-      glBindVertexArray(layer.vao);
-      glBindTexture(GL_TEXTURE_2D_ARRAY, layer.texture);
-      glDrawArrays(GL_TRIANGLES, 0, layer.nIndices);
+    this->uploadViewUniforms();
+
+    const auto visibleBounds = visibleTileBounds(this->m_viewMatrix);
+    for (auto layerN = LayerIdx{0}; layerN < this->m_layers.size(); layerN++) {
+      const auto &layer = this->m_layers[layerN];
+      if (visibleBounds && !layer.bounds.overlaps(*visibleBounds)) {
+        m_frameStats.chunksCulled +=
+            static_cast<unsigned int>(layer.chunks.size());
+        continue;
+      }
+      if (layer.mode == LayerRenderMode::TileMap) {
+        submitTileMapLayer(layerN, layer);
+      } else {
+        submitMeshLayer(layerN, layer, visibleBounds);
+      }
+    }
+    {
+      const auto scope = Profiler::Scope(m_pProfiler.get(), "layer draw");
+      const auto span = GpuTimer::Span(m_pGpuTimer.get(), "layer draw");
+      this->executeDrawCommands();
     }
-    // Ensure that we keep the vertex array unbound just to keep global state
-    // cleaned up.
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-    glBindVertexArray(0);
+    {
+      const auto scope = Profiler::Scope(m_pProfiler.get(), "sprite draw");
+      const auto span = GpuTimer::Span(m_pGpuTimer.get(), "sprite draw");
+      this->drawSprites(visibleBounds);
+    }
+    this->releaseSprites();
+    m_pStreamBuffer->endFrame();
+
+    const auto counters = m_glState.takeCounters();
+    m_frameStats.stateChanges = counters.changes;
+    m_frameStats.stateChangesAvoided = counters.avoided;
+    const auto streamCounters = m_pStreamBuffer->takeCounters();
+    m_frameStats.bytesStreamed = streamCounters.bytes;
+    m_frameStats.streamStalls = streamCounters.stalls;
+
+    this->checkFrameErrors();
   }
 
   void resize(const int width, const int height) {
     glViewport(0, 0, width, height);
+    this->m_viewportSize = {static_cast<float>(width),
+                            static_cast<float>(height)};
   }
 }; // namespace mata
 
 Renderer::Renderer(
     const Window &window,
-    const std::shared_ptr<mata::platform::VirtualFileSystem> _pVfs)
-    : m_pImpl(std::make_unique<Impl>(window, _pVfs)) {}
+    const std::shared_ptr<mata::platform::VirtualFileSystem> _pVfs,
+    const RendererParams &params)
+    : m_pImpl(std::make_unique<Impl>(window, _pVfs, params)) {}
 
 Renderer::~Renderer() noexcept = default;
 
+void Renderer::submitSprites(const Tileset &tileset,
+                             const std::vector<Sprite> &sprites) {
+  m_pImpl->submitSprites(tileset, sprites);
+}
+
+void Renderer::useOnCurrentThread() { m_pImpl->useOnCurrentThread(); }
+
 void Renderer::updateCamera(const Camera &camera) noexcept {
   m_pImpl->updateCamera(camera);
 }
 
-void Renderer::setLayer(const LayerIdx layerN, const TileLayer &layer) {
-  m_pImpl->setLayer(layerN, layer);
+void Renderer::setAnimationTime(const std::chrono::milliseconds time) noexcept {
+  m_pImpl->setAnimationTime(time);
+}
+
+void Renderer::setLayer(const LayerIdx layerN, const TileLayer &layer,
+                        const LayerRenderMode mode) {
+  m_pImpl->setLayer(layerN, layer, mode);
+}
+
+void Renderer::setTile(const LayerIdx layerN, const mata::core::Index2d &index,
+                       const TileId tile) {
+  m_pImpl->setTiles(layerN, index, {1, 1}, {tile});
+}
+
+void Renderer::setTiles(const LayerIdx layerN,
+                        const mata::core::Index2d &origin,
+                        const mata::core::GridDimensions2d &dimensions,
+                        const std::vector<TileId> &tiles) {
+  m_pImpl->setTiles(layerN, origin, dimensions, tiles);
+}
+
+std::size_t Renderer::evictUnusedTilesets() {
+  return m_pImpl->evictUnusedTilesets();
 }
 
 void Renderer::toggleWireframeMode() { m_pImpl->toggleWireframeMode(); }
 
+Renderer::FrameStats Renderer::frameStats() const noexcept {
+  return m_pImpl->frameStats();
+}
+
+GlErrorCheckMode Renderer::errorCheckMode() const noexcept {
+  return m_pImpl->errorCheckMode();
+}
+
 void Renderer::drawFrame() { m_pImpl->drawFrame(); }
 
 void Renderer::resize(const int width, const int height) {
@@ -0,0 +1,182 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include <glbinding/gl33core/gl.h>
+
+#include <mata/core/types.hpp>
+
+#include "stream_buffer.hpp"
+
+using namespace gl;
+
+namespace mata {
+namespace renderer {
+
+namespace {
+
+// How long to wait on a fence before flushing and checking again.
+constexpr GLuint64 FENCE_TIMEOUT_NS = 1000000;
+
+// The stream buffer is only ever a copy or unpack source, so mapping it
+// through this target leaves the vertex array and array buffer bindings
+// alone.
+constexpr GLenum MAP_TARGET = GL_COPY_READ_BUFFER;
+
+} // namespace
+
+StreamBuffer::StreamBuffer(const std::size_t frameCapacity,
+                           const bool persistent)
+    : m_frameCapacity(frameCapacity), m_persistent(persistent) {
+  this->create();
+}
+
+StreamBuffer::~StreamBuffer() noexcept { this->destroy(); }
+
+void StreamBuffer::create() {
+  const auto size = static_cast<GLsizeiptr>(m_frameCapacity * N_FRAMES);
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(MAP_TARGET, m_buffer);
+  if (m_persistent) {
+    glBufferStorage(MAP_TARGET, size, nullptr,
+                    BufferStorageMask::GL_MAP_WRITE_BIT |
+                        BufferStorageMask::GL_MAP_PERSISTENT_BIT |
+                        BufferStorageMask::GL_MAP_COHERENT_BIT);
+    m_pPersistentData = static_cast<mata::core::byte *>(glMapBufferRange(
+        MAP_TARGET, 0, size,
+        MapBufferAccessMask::GL_MAP_WRITE_BIT |
+            MapBufferAccessMask::GL_MAP_PERSISTENT_BIT |
+            MapBufferAccessMask::GL_MAP_COHERENT_BIT));
+    if (m_pPersistentData == nullptr) {
+      throw std::runtime_error("failed to map stream buffer");
+    }
+  } else {
+    glBufferData(MAP_TARGET, size, nullptr, GL_STREAM_DRAW);
+  }
+  glBindBuffer(MAP_TARGET, 0);
+}
+
+void StreamBuffer::destroy() noexcept {
+  for (auto &fence : m_fences) {
+    if (fence != nullptr) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+  if (m_pPersistentData != nullptr) {
+    glBindBuffer(MAP_TARGET, m_buffer);
+    glUnmapBuffer(MAP_TARGET);
+    glBindBuffer(MAP_TARGET, 0);
+    m_pPersistentData = nullptr;
+  }
+  // GL keeps the storage alive until the commands reading it are done.
+  glDeleteBuffers(1, &m_buffer);
+  m_buffer = 0;
+}
+
+void StreamBuffer::waitForFrame(const std::size_t frame) {
+  auto &fence = m_fences[frame];
+  if (fence == nullptr) {
+    return;
+  }
+  auto result = glClientWaitSync(fence, SyncObjectMask::GL_NONE_BIT, 0);
+  if (result == GL_TIMEOUT_EXPIRED) {
+    m_counters.stalls++;
+    do {
+      result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                FENCE_TIMEOUT_NS);
+    } while (result == GL_TIMEOUT_EXPIRED);
+  }
+  glDeleteSync(fence);
+  fence = nullptr;
+  if (result == GL_WAIT_FAILED) {
+    throw std::runtime_error("failed to wait for stream buffer fence");
+  }
+}
+
+StreamBuffer::Allocation StreamBuffer::map(const std::size_t size,
+                                           const std::size_t alignment) {
+  if (m_mapped) {
+    throw std::logic_error("stream buffer is already mapped");
+  }
+  auto offset = (m_frameSize + alignment - 1) / alignment * alignment;
+  if (offset + size > m_frameCapacity) {
+    // Start over with a buffer big enough for the whole frame. Nothing in
+    // the new buffer is in use yet, so there's nothing to wait for.
+    auto capacity = m_frameCapacity * 2;
+    while (capacity < size) {
+      capacity *= 2;
+    }
+    this->destroy();
+    m_frameCapacity = capacity;
+    this->create();
+    m_frameSize = 0;
+    offset = 0;
+  }
+
+  const auto bufferOffset = m_frame * m_frameCapacity + offset;
+  m_frameSize = offset + size;
+  m_counters.bytes += size;
+  m_mapped = true;
+  if (m_persistent) {
+    return {m_pPersistentData + bufferOffset, bufferOffset};
+  }
+  // Unsynchronized is safe because this region's last frame has already
+  // been waited on.
+  glBindBuffer(MAP_TARGET, m_buffer);
+  const auto pData = static_cast<mata::core::byte *>(glMapBufferRange(
+      MAP_TARGET, static_cast<GLintptr>(bufferOffset),
+      static_cast<GLsizeiptr>(size),
+      MapBufferAccessMask::GL_MAP_WRITE_BIT |
+          MapBufferAccessMask::GL_MAP_INVALIDATE_RANGE_BIT |
+          MapBufferAccessMask::GL_MAP_UNSYNCHRONIZED_BIT));
+  if (pData == nullptr) {
+    glBindBuffer(MAP_TARGET, 0);
+    m_mapped = false;
+    throw std::runtime_error("failed to map stream buffer");
+  }
+  return {pData, bufferOffset};
+}
+
+void StreamBuffer::unmap() {
+  if (!m_mapped) {
+    throw std::logic_error("stream buffer isn't mapped");
+  }
+  m_mapped = false;
+  if (!m_persistent) {
+    glBindBuffer(MAP_TARGET, m_buffer);
+    glUnmapBuffer(MAP_TARGET);
+    glBindBuffer(MAP_TARGET, 0);
+  }
+}
+
+std::size_t StreamBuffer::upload(const void *pData, const std::size_t size,
+                                 const std::size_t alignment) {
+  const auto allocation = this->map(size, alignment);
+  std::memcpy(allocation.pData, pData, size);
+  this->unmap();
+  return allocation.offset;
+}
+
+void StreamBuffer::endFrame() {
+  if (m_frameSize > 0) {
+    m_fences[m_frame] =
+        glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, UnusedMask::GL_NONE_BIT);
+  }
+  m_frame = (m_frame + 1) % N_FRAMES;
+  m_frameSize = 0;
+  this->waitForFrame(m_frame);
+}
+
+StreamBuffer::Counters StreamBuffer::takeCounters() noexcept {
+  const auto counters = m_counters;
+  m_counters = {};
+  return counters;
+}
+
+} // namespace renderer
+} // namespace mata
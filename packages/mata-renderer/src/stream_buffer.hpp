@@ -0,0 +1,87 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <glbinding/gl/types.h>
+
+#include <mata/core/types.hpp>
+#include <mata/utils/noncopyable.hpp>
+
+namespace mata {
+namespace renderer {
+
+// A ring buffer for data that's written every frame, such as edited tiles or
+// sprites. The buffer is split into one region per frame in flight, and each
+// region is fenced once its frame has been submitted. Writing never waits on
+// the GPU unless it's more than N_FRAMES frames behind.
+//
+// With GL_ARB_buffer_storage the whole buffer is mapped once, persistently.
+// Otherwise every allocation maps its own range unsynchronized, which the
+// fences make safe.
+class StreamBuffer final : mata::utils::noncopyable {
+public:
+  static constexpr std::size_t N_FRAMES = 3;
+
+  struct Allocation {
+    mata::core::byte *pData;
+    // The allocation's offset into buffer(), to pass to GL in place of a
+    // pointer.
+    std::size_t offset;
+  };
+
+  struct Counters {
+    std::size_t bytes = 0;
+    // Frames that had to wait for the GPU before reusing their region.
+    unsigned int stalls = 0;
+  };
+
+private:
+  gl::GLuint m_buffer = 0;
+  std::size_t m_frameCapacity;
+  bool m_persistent;
+  mata::core::byte *m_pPersistentData = nullptr;
+  std::array<gl::GLsync, N_FRAMES> m_fences{};
+  std::size_t m_frame = 0;
+  std::size_t m_frameSize = 0;
+  bool m_mapped = false;
+  Counters m_counters{};
+
+  void create();
+  void destroy() noexcept;
+  void waitForFrame(const std::size_t frame);
+
+public:
+  // Must be created and destroyed with the GL context current.
+  StreamBuffer(const std::size_t frameCapacity, const bool persistent);
+  ~StreamBuffer() noexcept;
+
+  // Changes when the buffer grows, so anything pointing at it must check.
+  [[nodiscard]] gl::GLuint buffer() const noexcept { return m_buffer; }
+
+  [[nodiscard]] bool persistent() const noexcept { return m_persistent; }
+
+  // Allocate size bytes from this frame's region, growing the buffer if they
+  // don't fit. The memory has to be written before unmap() and used by GL
+  // calls before the next map(), since growing orphans earlier allocations.
+  [[nodiscard]] Allocation map(const std::size_t size,
+                               const std::size_t alignment);
+  void unmap();
+
+  // Copy data into a new allocation and return its offset.
+  [[nodiscard]] std::size_t upload(const void *pData, const std::size_t size,
+                                   const std::size_t alignment);
+
+  // Fence this frame's commands and move on to the next region, waiting for
+  // the GPU to finish with it if it hasn't already.
+  void endFrame();
+
+  [[nodiscard]] Counters takeCounters() noexcept;
+};
+
+} // namespace renderer
+} // namespace mata
@@ -20,24 +20,42 @@ namespace renderer {
 class Texture::Impl {
 private:
   mata::core::GridDimensions2d m_dimensions;
-  mata::core::bytes m_rgba;
+  TextureFormat m_format;
+  // Pixels are immutable once loaded, so copies of a texture share them
+  // instead of duplicating what can be hundreds of megabytes.
+  std::shared_ptr<const void> m_pOwner;
+  mata::core::bytes_view m_bytes;
 
 public:
   Impl(const mata::core::GridDimensions2d &dimensions,
-       const mata::core::bytes &rgba) noexcept
-      : m_dimensions(dimensions), m_rgba(rgba) {}
+       const TextureFormat format, mata::core::bytes data)
+      : m_dimensions(dimensions), m_format(format) {
+    const auto pData =
+        std::make_shared<const mata::core::bytes>(std::move(data));
+    m_bytes = *pData;
+    m_pOwner = pData;
+  }
+
+  Impl(const mata::core::GridDimensions2d &dimensions,
+       const TextureFormat format, std::shared_ptr<const void> pOwner,
+       const mata::core::bytes_view data) noexcept
+      : m_dimensions(dimensions), m_format(format),
+        m_pOwner(std::move(pOwner)), m_bytes(data) {}
 
   mata::core::GridDimensions2d dimensions() const noexcept {
     return m_dimensions;
   }
 
-  const mata::core::bytes &asBytes() const noexcept { return m_rgba; }
+  TextureFormat format() const noexcept { return m_format; }
+
+  mata::core::bytes_view asBytes() const noexcept { return m_bytes; }
 };
 
-Texture Texture::fromPng(const mata::core::bytes &png) {
+Texture Texture::fromPng(const mata::core::bytes_view png) {
   auto rgba = mata::core::bytes{};
   unsigned int width, height;
-  const auto error = lodepng::decode(rgba, width, height, png);
+  const auto error =
+      lodepng::decode(rgba, width, height, png.data(), png.size());
   if (error) {
     throw std::runtime_error(fmt::format(
         "failed to decode PNG as RGBA texture: {}", lodepng_error_text(error)));
@@ -47,8 +65,17 @@ Texture Texture::fromPng(const mata::core::bytes &png) {
 }
 
 Texture::Texture(const mata::core::GridDimensions2d &dimensions,
-                 const mata::core::bytes &rgba)
-    : m_pImpl(std::make_unique<Impl>(dimensions, rgba)) {}
+                 mata::core::bytes rgba)
+    : m_pImpl(std::make_unique<Impl>(dimensions, TextureFormat::Rgba8,
+                                     std::move(rgba))) {}
+Texture::Texture(const mata::core::GridDimensions2d &dimensions,
+                 const TextureFormat format, mata::core::bytes data)
+    : m_pImpl(std::make_unique<Impl>(dimensions, format, std::move(data))) {}
+Texture::Texture(const mata::core::GridDimensions2d &dimensions,
+                 const TextureFormat format, std::shared_ptr<const void> pOwner,
+                 const mata::core::bytes_view data) noexcept
+    : m_pImpl(std::make_unique<Impl>(dimensions, format, std::move(pOwner),
+                                     data)) {}
 Texture::~Texture() noexcept = default;
 
 Texture::Texture(const Texture &texture) noexcept
@@ -69,7 +96,9 @@ mata::core::GridDimensions2d Texture::dimensions() const noexcept {
   return m_pImpl->dimensions();
 }
 
-const mata::core::bytes &Texture::asBytes() const noexcept {
+TextureFormat Texture::format() const noexcept { return m_pImpl->format(); }
+
+mata::core::bytes_view Texture::asBytes() const noexcept {
   return m_pImpl->asBytes();
 }
 
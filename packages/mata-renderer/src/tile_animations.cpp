@@ -0,0 +1,49 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <mata/core/geometry.hpp>
+
+#include "mata/renderer/tileset.hpp"
+#include "tile_animations.hpp"
+
+namespace mata {
+namespace renderer {
+
+std::vector<std::int32_t> tileAnimationTable(const Tileset &tileset) {
+  const auto dimensions = tileset.dimensions();
+  const auto &animations = tileset.animations();
+
+  auto nHeaders = 1;
+  for (const auto &animation : animations) {
+    nHeaders = std::max(
+        nHeaders, mata::core::index2dTo1d(animation.tile, dimensions) + 1);
+  }
+
+  auto table =
+      std::vector<std::int32_t>(2 * static_cast<std::size_t>(nHeaders));
+  auto nFrames = 0;
+  for (const auto &animation : animations) {
+    const auto header = 2 * static_cast<std::size_t>(mata::core::index2dTo1d(
+                                animation.tile, dimensions));
+    table[header] = nHeaders + nFrames;
+    table[header + 1] = static_cast<std::int32_t>(animation.frames.size());
+
+    auto endTime = std::int32_t{0};
+    for (const auto &frame : animation.frames) {
+      endTime += static_cast<std::int32_t>(frame.duration.count());
+      table.push_back(mata::core::index2dTo1d(frame.tile, dimensions));
+      table.push_back(endTime);
+    }
+    nFrames += static_cast<int>(animation.frames.size());
+  }
+  return table;
+}
+
+} // namespace renderer
+} // namespace mata
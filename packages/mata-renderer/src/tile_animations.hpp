@@ -0,0 +1,29 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mata/renderer/tileset.hpp"
+
+namespace mata {
+namespace renderer {
+
+// A tileset's animations flattened into pairs of integers, uploaded as an
+// RG32I buffer texture that the tile shaders look animated tiles up in:
+//
+//   [0, nHeaders)    one per tile index: first frame, number of frames, with
+//                    no frames for tiles that aren't animated
+//   [nHeaders, ...)  one per frame: tile index, end time in milliseconds
+//                    since the animation started
+//
+// Tile indices past the headers aren't animated. There's always at least one
+// header so that the texture is never empty.
+[[nodiscard]] std::vector<std::int32_t>
+tileAnimationTable(const Tileset &tileset);
+
+} // namespace renderer
+} // namespace mata
@@ -2,32 +2,135 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <algorithm>
+#include <cstddef>
 #include <memory>
+#include <optional>
+#include <stdexcept>
 #include <vector>
 
+#include <fmt/format.h>
+
 #include <mata/core/geometry.hpp>
 
+#include "mata/renderer/tile_id.hpp"
 #include "mata/renderer/tile_layer.hpp"
 #include "mata/renderer/tileset.hpp"
+#include "tile_layer_mesh.hpp"
 
 namespace mata {
 namespace renderer {
 
+namespace {
+
+void checkTilesetFits(const Tileset &tileset) {
+  const auto dimensions = tileset.dimensions();
+  if (dimensions.nColumns * dimensions.nRows > TileId::MAX_INDEX + 1) {
+    throw std::logic_error(fmt::format(
+        "tileset of {0} tiles has more than tile ids can index ({1})",
+        dimensions.nColumns * dimensions.nRows, TileId::MAX_INDEX + 1));
+  }
+}
+
+void checkTileInTileset(const Tileset &tileset, const TileId tile) {
+  const auto dimensions = tileset.dimensions();
+  if (!tile.isEmpty() &&
+      tile.index() >= dimensions.nColumns * dimensions.nRows) {
+    throw std::logic_error(
+        fmt::format("tile {0} is outside of the tileset of {1} tiles",
+                    tile.index(), dimensions.nColumns * dimensions.nRows));
+  }
+}
+
+std::vector<TileId> packTiles(const Tileset &tileset,
+                              const std::vector<mata::core::Index2d> &tiles) {
+  checkTilesetFits(tileset);
+  const auto dimensions = tileset.dimensions();
+  auto tileIds = std::vector<TileId>{};
+  tileIds.reserve(tiles.size());
+  for (const auto &tile : tiles) {
+    if (tile.i < 0 || tile.j < 0 || tile.i >= dimensions.nColumns ||
+        tile.j >= dimensions.nRows) {
+      throw std::logic_error(
+          fmt::format("tile ({0}, {1}) is outside of the tileset", tile.i,
+                      tile.j));
+    }
+    tileIds.emplace_back(mata::core::index2dTo1d(tile, dimensions));
+  }
+  return tileIds;
+}
+
+} // namespace
+
 class TileLayer::Impl {
 private:
+  using DenseTiles =
+      mata::core::GridContainer<TileId, mata::core::TiledLayout<CHUNK_SIZE>>;
+  using SparseTiles = mata::core::SparseGridContainer<TileId, CHUNK_SIZE>;
+
   mata::core::GridDimensions2d m_dimensions;
   Tileset m_tileset;
-  mata::core::GridContainer<mata::core::Index2d> m_tiles;
+  // Exactly one is set, depending on the storage. Both store tiles in the
+  // same chunks that meshes are built from, so building one reads a single
+  // contiguous block.
+  std::optional<DenseTiles> m_denseTiles = std::nullopt;
+  std::optional<SparseTiles> m_sparseTiles = std::nullopt;
 
 public:
-  Impl(const mata::core::GridDimensions2d &dimensions,
-       const Tileset &tileset) noexcept
-      : m_dimensions(dimensions), m_tileset(tileset), m_tiles(dimensions) {}
+  Impl(const mata::core::GridDimensions2d &dimensions, const Tileset &tileset,
+       const std::vector<TileId> &tiles, const TileStorage storage)
+      : m_dimensions(dimensions), m_tileset(tileset) {
+    checkTilesetFits(tileset);
+    if (tiles.size() != static_cast<std::size_t>(dimensions.nColumns) *
+                            static_cast<std::size_t>(dimensions.nRows)) {
+      throw std::logic_error(
+          fmt::format("expected {0} tiles but got {1}",
+                      dimensions.nColumns * dimensions.nRows, tiles.size()));
+    }
+    for (const auto &tile : tiles) {
+      checkTileInTileset(tileset, tile);
+    }
+    if (storage == TileStorage::Sparse) {
+      m_sparseTiles.emplace(dimensions, tiles, TileId::empty());
+    } else {
+      m_denseTiles.emplace(dimensions, tiles);
+    }
+  }
+
+  Impl(const mata::core::GridDimensions2d &dimensions, const Tileset &tileset,
+       const TileStorage storage)
+      : m_dimensions(dimensions), m_tileset(tileset) {
+    checkTilesetFits(tileset);
+    if (storage == TileStorage::Sparse) {
+      m_sparseTiles.emplace(dimensions, TileId::empty());
+    } else {
+      m_denseTiles.emplace(
+          dimensions,
+          std::vector<TileId>(static_cast<std::size_t>(dimensions.nColumns) *
+                                  static_cast<std::size_t>(dimensions.nRows),
+                              TileId::empty()));
+    }
+  }
 
   Impl(const mata::core::GridDimensions2d &dimensions, const Tileset &tileset,
-       const std::vector<mata::core::Index2d> &tiles) noexcept
-      : m_dimensions(dimensions), m_tileset(tileset),
-        m_tiles(dimensions, tiles) {}
+       const std::vector<PlacedTile> &tiles, const TileStorage storage)
+      : Impl(dimensions, tileset, storage) {
+    for (const auto &tile : tiles) {
+      if (tile.index.i < 0 || tile.index.j < 0 ||
+          tile.index.i >= dimensions.nColumns ||
+          tile.index.j >= dimensions.nRows) {
+        throw std::logic_error(
+            fmt::format("tile placed at ({0}, {1}) is outside of the layer",
+                        tile.index.i, tile.index.j));
+      }
+      checkTileInTileset(tileset, tile.tile);
+      if (m_sparseTiles) {
+        m_sparseTiles->set(tile.index, tile.tile);
+      } else {
+        m_denseTiles->set(tile.index, tile.tile);
+      }
+    }
+  }
 
   mata::core::GridDimensions2d dimensions() const noexcept {
     return m_dimensions;
@@ -35,19 +138,69 @@ public:
 
   const Tileset &tileset() const noexcept { return m_tileset; }
 
-  mata::core::Index2d tileAt(const mata::core::Index2d &index) const noexcept {
-    return m_tiles.at(index);
+  TileStorage storage() const noexcept {
+    return m_sparseTiles ? TileStorage::Sparse : TileStorage::Dense;
+  }
+
+  TileId tileAt(const mata::core::Index2d &index) const noexcept {
+    return m_sparseTiles ? (*m_sparseTiles)[index] : (*m_denseTiles)[index];
+  }
+
+  bool isEmptyIn(const mata::core::Index2d &origin,
+                 const mata::core::GridDimensions2d &dimensions) const
+      noexcept {
+    const auto begin =
+        mata::core::Index2d{std::max(origin.i, 0), std::max(origin.j, 0)};
+    const auto end = mata::core::Index2d{
+        std::min(origin.i + dimensions.nColumns, m_dimensions.nColumns),
+        std::min(origin.j + dimensions.nRows, m_dimensions.nRows)};
+    if (begin.i >= end.i || begin.j >= end.j) {
+      return true;
+    }
+    // Skip the chunks that were never stored, which are empty throughout.
+    for (auto chunkRow = begin.j / CHUNK_SIZE;
+         chunkRow <= (end.j - 1) / CHUNK_SIZE; chunkRow++) {
+      for (auto chunkCol = begin.i / CHUNK_SIZE;
+           chunkCol <= (end.i - 1) / CHUNK_SIZE; chunkCol++) {
+        if (m_sparseTiles &&
+            !m_sparseTiles->isChunkAllocated({chunkCol, chunkRow})) {
+          continue;
+        }
+        for (auto j = std::max(begin.j, chunkRow * CHUNK_SIZE);
+             j < std::min(end.j, (chunkRow + 1) * CHUNK_SIZE); j++) {
+          for (auto i = std::max(begin.i, chunkCol * CHUNK_SIZE);
+               i < std::min(end.i, (chunkCol + 1) * CHUNK_SIZE); i++) {
+            if (!tileAt({i, j}).isEmpty()) {
+              return false;
+            }
+          }
+        }
+      }
+    }
+    return true;
   }
 };
 
 TileLayer::TileLayer(const mata::core::GridDimensions2d &dimensions,
                      const Tileset &tileset,
-                     const std::vector<mata::core::Index2d> &tiles) noexcept
-    : m_pImpl(std::make_unique<Impl>(dimensions, tileset, tiles)) {}
+                     const std::vector<TileId> &tiles,
+                     const TileStorage storage)
+    : m_pImpl(std::make_unique<Impl>(dimensions, tileset, tiles, storage)) {}
+
+TileLayer::TileLayer(const mata::core::GridDimensions2d &dimensions,
+                     const Tileset &tileset,
+                     const std::vector<mata::core::Index2d> &tiles)
+    : TileLayer(dimensions, tileset, packTiles(tileset, tiles)) {}
+
+TileLayer::TileLayer(const mata::core::GridDimensions2d &dimensions,
+                     const Tileset &tileset,
+                     const std::vector<PlacedTile> &tiles,
+                     const TileStorage storage)
+    : m_pImpl(std::make_unique<Impl>(dimensions, tileset, tiles, storage)) {}
 
 TileLayer::TileLayer(const mata::core::GridDimensions2d &dimensions,
-                     const Tileset &tileset) noexcept
-    : m_pImpl(std::make_unique<Impl>(dimensions, tileset)) {}
+                     const Tileset &tileset, const TileStorage storage)
+    : m_pImpl(std::make_unique<Impl>(dimensions, tileset, storage)) {}
 
 TileLayer::~TileLayer() noexcept = default;
 
@@ -71,10 +224,17 @@ const Tileset &TileLayer::tileset() const noexcept {
   return m_pImpl->tileset();
 }
 
-mata::core::Index2d
-TileLayer::tileAt(const mata::core::Index2d &index) const noexcept {
+TileStorage TileLayer::storage() const noexcept { return m_pImpl->storage(); }
+
+TileId TileLayer::tileAt(const mata::core::Index2d &index) const noexcept {
   return m_pImpl->tileAt(index);
 }
 
+bool TileLayer::isEmptyIn(
+    const mata::core::Index2d &origin,
+    const mata::core::GridDimensions2d &dimensions) const noexcept {
+  return m_pImpl->isEmptyIn(origin, dimensions);
+}
+
 } // namespace renderer
 } // namespace mata
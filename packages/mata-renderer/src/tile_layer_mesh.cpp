@@ -0,0 +1,62 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <cstddef>
+
+#include <glm/vec2.hpp>
+
+#include <mata/core/geometry.hpp>
+
+#include "mata/renderer/tile_layer.hpp"
+#include "tile_layer_mesh.hpp"
+
+namespace mata {
+namespace renderer {
+
+TileLayerMesh::TileLayerMesh(const TileLayer &layer) noexcept
+    : m_nChunks({(layer.dimensions().nColumns + CHUNK_SIZE - 1) / CHUNK_SIZE,
+                 (layer.dimensions().nRows + CHUNK_SIZE - 1) / CHUNK_SIZE}) {
+  const auto dimensions = layer.dimensions();
+  // Sparse layers are mostly empty, so only dense ones are worth reserving
+  // an instance per cell for.
+  if (layer.storage() == TileStorage::Dense) {
+    m_instances.reserve(
+        static_cast<std::size_t>(dimensions.nColumns * dimensions.nRows));
+  }
+  m_chunks.reserve(
+      static_cast<std::size_t>(m_nChunks.nColumns * m_nChunks.nRows));
+  for (auto chunkRow = 0; chunkRow < m_nChunks.nRows; chunkRow++) {
+    for (auto chunkCol = 0; chunkCol < m_nChunks.nColumns; chunkCol++) {
+      const auto origin =
+          mata::core::Index2d{chunkCol * CHUNK_SIZE, chunkRow * CHUNK_SIZE};
+      const auto end = mata::core::Index2d{
+          std::min(origin.i + CHUNK_SIZE, dimensions.nColumns),
+          std::min(origin.j + CHUNK_SIZE, dimensions.nRows)};
+      const auto firstInstance = m_instances.size();
+      if (!layer.isEmptyIn(origin, {CHUNK_SIZE, CHUNK_SIZE})) {
+        for (auto j = origin.j; j < end.j; j++) {
+          for (auto i = origin.i; i < end.i; i++) {
+            const auto tile = layer.tileAt({i, j});
+            if (tile.isEmpty()) {
+              continue;
+            }
+            m_instances.push_back(
+                {static_cast<TileInstance::GridPositionType>(i),
+                 static_cast<TileInstance::GridPositionType>(j),
+                 tile.value()});
+          }
+        }
+      }
+      m_chunks.push_back(
+          {firstInstance, static_cast<int>(m_instances.size() - firstInstance),
+           {glm::vec2(static_cast<float>(origin.i),
+                      static_cast<float>(origin.j)),
+            glm::vec2(static_cast<float>(end.i), static_cast<float>(end.j))}});
+    }
+  }
+}
+
+} // namespace renderer
+} // namespace mata
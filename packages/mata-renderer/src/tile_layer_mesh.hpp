@@ -0,0 +1,79 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include <mata/core/geometry.hpp>
+
+#include "mata/renderer/tile_layer.hpp"
+
+namespace mata {
+namespace renderer {
+
+// Per-tile instance data: the tile's position in the layer grid packed into
+// two 16-bit integers, and the tile's packed TileId, which the vertex shader
+// decodes. The id is widened to keep the instance 4 byte aligned.
+struct TileInstance {
+  using GridPositionType = std::uint16_t;
+  using TileType = std::uint32_t;
+
+  GridPositionType i;
+  GridPositionType j;
+  TileType tile;
+};
+
+// Tile layers are split into square chunks of tiles, each drawn separately,
+// so that drawFrame only has to submit the chunks that the camera can see.
+static constexpr auto CHUNK_SIZE = 32;
+
+// Axis-aligned bounds in tile space, where tile (i, j) covers [i, i + 1) x
+// [j, j + 1).
+struct TileBounds {
+  glm::vec2 min;
+  glm::vec2 max;
+
+  [[nodiscard]] bool overlaps(const TileBounds &other) const noexcept {
+    return min.x < other.max.x && other.min.x < max.x && min.y < other.max.y &&
+           other.min.y < max.y;
+  }
+};
+
+// The instances a mesh layer is drawn with, built on the CPU.
+class TileLayerMesh {
+public:
+  struct Chunk {
+    std::size_t firstInstance;
+    int nInstances;
+    TileBounds bounds;
+  };
+
+private:
+  mata::core::GridDimensions2d m_nChunks;
+  std::vector<TileInstance> m_instances = {};
+  std::vector<Chunk> m_chunks = {};
+
+public:
+  // Instances are laid out chunk by chunk, with chunks stored row by row, so
+  // that each chunk is a contiguous range of the instance buffer. Empty
+  // cells get no instance, so chunks hold anywhere from none to
+  // CHUNK_SIZE * CHUNK_SIZE of them.
+  TileLayerMesh(const TileLayer &layer) noexcept;
+
+  mata::core::GridDimensions2d nChunks() const noexcept { return m_nChunks; }
+
+  const std::vector<TileInstance> &instances() const noexcept {
+    return m_instances;
+  }
+
+  const std::vector<Chunk> &chunks() const noexcept { return m_chunks; }
+};
+
+} // namespace renderer
+} // namespace mata
@@ -3,8 +3,16 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 #include <utility>
+#include <vector>
+
+#include <fmt/format.h>
 
 #include <mata/core/geometry.hpp>
 
@@ -15,23 +23,29 @@ namespace renderer {
 
 class Tileset::Impl final {
 private:
-  static const auto N_COLOR_CHANNELS = 4; // rgba
+  static const std::size_t N_COLOR_CHANNELS = 4; // rgba
 
   static std::size_t
   nBytesPerTile(const mata::core::GridDimensions2d tileSize) {
-    return static_cast<std::size_t>(tileSize.nColumns * tileSize.nRows *
-                                    N_COLOR_CHANNELS);
+    return static_cast<std::size_t>(tileSize.nColumns * tileSize.nRows) *
+           N_COLOR_CHANNELS;
   }
 
   mata::core::GridDimensions2d m_tileSize;
   mata::core::GridDimensions2d m_dimensions;
   Texture m_texture;
+  TileLayout m_layout;
+  std::vector<TileAnimation> m_animations = {};
 
 public:
   Impl(const mata::core::GridDimensions2d tileSize,
-       const mata::core::GridDimensions2d dimensions,
-       const Texture &texture) noexcept
-      : m_tileSize(tileSize), m_dimensions(dimensions), m_texture(texture) {}
+       const mata::core::GridDimensions2d dimensions, const Texture &texture,
+       const TileLayout layout) noexcept
+      : m_tileSize(tileSize), m_dimensions(dimensions), m_texture(texture),
+        // Compressed blocks can't be transposed pixel row by pixel row.
+        m_layout(texture.format() == TextureFormat::Rgba8
+                     ? layout
+                     : TileLayout::Stacked) {}
 
   mata::core::GridDimensions2d dimensions() const noexcept {
     return m_dimensions;
@@ -41,6 +55,48 @@ public:
 
   const Texture &texture() const noexcept { return m_texture; }
 
+  TileLayout layout() const noexcept { return m_layout; }
+
+  void setAnimations(std::vector<TileAnimation> animations) {
+    const auto contains = [this](const mata::core::Index2d &tile) {
+      return tile.i >= 0 && tile.j >= 0 && tile.i < m_dimensions.nColumns &&
+             tile.j < m_dimensions.nRows;
+    };
+    for (auto n = std::size_t{0}; n < animations.size(); n++) {
+      const auto &animation = animations[n];
+      if (!contains(animation.tile)) {
+        throw std::logic_error(
+            fmt::format("animated tile ({0}, {1}) is outside of the tileset",
+                        animation.tile.i, animation.tile.j));
+      }
+      if (animation.frames.empty()) {
+        throw std::logic_error(
+            fmt::format("animation of tile ({0}, {1}) has no frames",
+                        animation.tile.i, animation.tile.j));
+      }
+      for (const auto &frame : animation.frames) {
+        if (!contains(frame.tile) || frame.duration.count() <= 0) {
+          throw std::logic_error(fmt::format(
+              "animation of tile ({0}, {1}) has an invalid frame",
+              animation.tile.i, animation.tile.j));
+        }
+      }
+      for (auto m = std::size_t{0}; m < n; m++) {
+        if (mata::core::index2dTo1d(animations[m].tile, m_dimensions) ==
+            mata::core::index2dTo1d(animation.tile, m_dimensions)) {
+          throw std::logic_error(
+              fmt::format("tile ({0}, {1}) is animated more than once",
+                          animation.tile.i, animation.tile.j));
+        }
+      }
+    }
+    m_animations = std::move(animations);
+  }
+
+  const std::vector<TileAnimation> &animations() const noexcept {
+    return m_animations;
+  }
+
   // When loaded from disk, the sprite atlas stores its bytes from left to
   // to right, top to bottom for the entire texture. We want to transpose the
   // pixel bytes so that we end up with all of our tiles vertically stacked in
@@ -60,9 +116,8 @@ public:
   //                           | 444444 |
   //                           +--------+
   //
-  // To do this we scan the pixels in the texture row by row, then copy the
-  // individual rows in each tile within that row to an appropriate offset in
-  // the dest texture:
+  // To do this we copy the individual rows of pixels in each tile to an
+  // appropriate offset in the dest texture:
   //
   // +--------+--------+       +--------+
   // |(111111)|(222222)|       |(111111)|
@@ -92,46 +147,104 @@ public:
   //                           |        |
   //                           +--------+
   // ... etc.
-  const mata::core::bytes asLinearBytes() const noexcept {
+  //
+  // Each row of pixels in a tile is contiguous in both textures, so it's
+  // copied as a single block with memcpy. Tiles are visited in dest order to
+  // keep the writes sequential, and large atlases are split between threads
+  // by tile row.
+  //
+  // Baked and compressed textures are stacked before they're stored, so their
+  // bytes are returned as they are.
+  mata::core::bytes_view asLinearBytes() const noexcept {
+    if (m_layout == TileLayout::Stacked) {
+      return m_texture.asBytes();
+    }
+    std::call_once(m_pLinearBytes->computed, [this]() {
+      m_pLinearBytes->bytes = this->transposeTiles();
+    });
+    return m_pLinearBytes->bytes;
+  }
+
+private:
+  // Atlases smaller than this are transposed on the calling thread.
+  static constexpr std::size_t MIN_BYTES_PER_THREAD = 4 * 1024 * 1024;
+
+  // The transposed bytes are computed on first use and shared between copies
+  // of the tileset.
+  struct LinearBytesCache {
+    std::once_flag computed;
+    mata::core::bytes bytes;
+  };
+  std::shared_ptr<LinearBytesCache> m_pLinearBytes =
+      std::make_shared<LinearBytesCache>();
+
+  mata::core::bytes transposeTiles() const {
     const auto textureBytes = m_texture.asBytes();
     auto linearBytes = mata::core::bytes(textureBytes.size());
 
-    const auto textureDims = m_texture.dimensions();
-    const auto tilesetDims = m_dimensions;
-    const auto nBytesPerTexturePxRow = textureDims.nColumns * N_COLOR_CHANNELS;
-    const auto nBytesPerTilePxRow = m_tileSize.nColumns * N_COLOR_CHANNELS;
-    const auto nPixelsPerTile = m_tileSize.nColumns * m_tileSize.nRows;
-    const auto nBytesPerTile = nPixelsPerTile * N_COLOR_CHANNELS;
-    for (auto pxRow = 0; pxRow < textureDims.nRows; pxRow++) {
-      const auto rowBytesOffset = nBytesPerTexturePxRow * pxRow;
-
-      // Subdivide each row of pixels in the texture into a row per tile.
-      for (auto tileCol = 0; tileCol < tilesetDims.nColumns; tileCol++) {
-        const auto srcStartOffset =
-            rowBytesOffset + nBytesPerTilePxRow * tileCol;
-        const auto srcEndOffset = srcStartOffset + nBytesPerTilePxRow;
-
-        // Map the 2d index in the source to a 1d index in the dest.
-        const auto tileRow = pxRow / m_tileSize.nRows;
-        const auto destTileIndex = tileRow * tilesetDims.nColumns + tileCol;
-        const auto tilePxRow = pxRow % m_tileSize.nColumns;
-        const auto destOffset =
-            (nBytesPerTile * destTileIndex) + (nBytesPerTilePxRow * tilePxRow);
-
-        std::copy(textureBytes.begin() + srcStartOffset,
-                  textureBytes.begin() + srcEndOffset,
-                  linearBytes.begin() + destOffset);
-      }
+    const auto nTileRows = static_cast<std::size_t>(m_dimensions.nRows);
+    const auto nThreads = std::clamp<std::size_t>(
+        std::min<std::size_t>(textureBytes.size() / MIN_BYTES_PER_THREAD,
+                              std::thread::hardware_concurrency()),
+        1, std::max<std::size_t>(nTileRows, 1));
+    if (nThreads == 1) {
+      this->transposeTileRows(textureBytes.data(), linearBytes.data(), 0,
+                              nTileRows);
+      return linearBytes;
     }
 
+    auto threads = std::vector<std::thread>();
+    threads.reserve(nThreads - 1);
+    const auto nTileRowsPerThread = (nTileRows + nThreads - 1) / nThreads;
+    for (auto first = nTileRowsPerThread; first < nTileRows;
+         first += nTileRowsPerThread) {
+      const auto last = std::min(first + nTileRowsPerThread, nTileRows);
+      threads.emplace_back([this, &textureBytes, &linearBytes, first, last]() {
+        this->transposeTileRows(textureBytes.data(), linearBytes.data(), first,
+                                last);
+      });
+    }
+    this->transposeTileRows(textureBytes.data(), linearBytes.data(), 0,
+                            std::min(nTileRowsPerThread, nTileRows));
+    for (auto &thread : threads) {
+      thread.join();
+    }
     return linearBytes;
   }
+
+  // Copy the tiles in rows [firstTileRow, lastTileRow) of the tileset to
+  // their place in the linear bytes.
+  void transposeTileRows(const mata::core::byte *src, mata::core::byte *dest,
+                         const std::size_t firstTileRow,
+                         const std::size_t lastTileRow) const noexcept {
+    const auto nTileCols = static_cast<std::size_t>(m_dimensions.nColumns);
+    const auto nTilePxCols = static_cast<std::size_t>(m_tileSize.nColumns);
+    const auto nTilePxRows = static_cast<std::size_t>(m_tileSize.nRows);
+    const auto nBytesPerTexturePxRow =
+        static_cast<std::size_t>(m_texture.dimensions().nColumns) *
+        N_COLOR_CHANNELS;
+    const auto nBytesPerTilePxRow = nTilePxCols * N_COLOR_CHANNELS;
+
+    auto pDest = dest + nBytesPerTile(m_tileSize) * nTileCols * firstTileRow;
+    for (auto tileRow = firstTileRow; tileRow < lastTileRow; tileRow++) {
+      const auto pTileRow = src + nBytesPerTexturePxRow * nTilePxRows * tileRow;
+      for (auto tileCol = std::size_t{0}; tileCol < nTileCols; tileCol++) {
+        auto pSrc = pTileRow + nBytesPerTilePxRow * tileCol;
+        for (auto tilePxRow = std::size_t{0}; tilePxRow < nTilePxRows;
+             tilePxRow++) {
+          std::memcpy(pDest, pSrc, nBytesPerTilePxRow);
+          pDest += nBytesPerTilePxRow;
+          pSrc += nBytesPerTexturePxRow;
+        }
+      }
+    }
+  }
 };
 
 Tileset::Tileset(const mata::core::GridDimensions2d tileSize,
                  const mata::core::GridDimensions2d dimensions,
-                 const Texture &texture) noexcept
-    : m_pImpl(std::make_unique<Impl>(tileSize, dimensions, texture)) {}
+                 const Texture &texture, const TileLayout layout) noexcept
+    : m_pImpl(std::make_unique<Impl>(tileSize, dimensions, texture, layout)) {}
 
 Tileset::~Tileset() noexcept = default;
 
@@ -156,7 +269,17 @@ mata::core::GridDimensions2d Tileset::tileSize() const noexcept {
 
 const Texture &Tileset::texture() const noexcept { return m_pImpl->texture(); }
 
-mata::core::bytes Tileset::asLinearBytes() const noexcept {
+TileLayout Tileset::layout() const noexcept { return m_pImpl->layout(); }
+
+void Tileset::setAnimations(std::vector<TileAnimation> animations) {
+  m_pImpl->setAnimations(std::move(animations));
+}
+
+const std::vector<TileAnimation> &Tileset::animations() const noexcept {
+  return m_pImpl->animations();
+}
+
+mata::core::bytes_view Tileset::asLinearBytes() const noexcept {
   return m_pImpl->asLinearBytes();
 }
 
@@ -26,18 +26,22 @@ private:
   ResizeCallback m_resizeCallback{nullptr};
   WindowCloseRequestedCallback m_windowCloseRequestedCallback{nullptr};
   KeyEventCallback m_keyEventCallback{nullptr};
-  double m_lastFrameTimestamp = -1.0;
 
 public:
-  Impl(const bool headless) {
+  Impl(const bool headless, const bool debugContext) {
     glfwSetErrorCallback(handleGlfwError);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // Sprites are depth tested.
+    glfwWindowHint(GLFW_DEPTH_BITS, 24);
 #if MATA_OS_MACOS
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    // Drivers may only report debug messages to debug contexts.
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT,
+                   debugContext ? GLFW_TRUE : GLFW_FALSE);
 
     if (headless) {
       glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
@@ -62,11 +66,13 @@ public:
     glfwTerminate();
   }
 
-  void update() {
-    glfwSwapBuffers(m_pWindow);
-    glfwPollEvents();
-    m_lastFrameTimestamp = glfwGetTime();
-  }
+  void swapBuffers() { glfwSwapBuffers(m_pWindow); }
+
+  void pollEvents() { glfwPollEvents(); }
+
+  void makeContextCurrent() { glfwMakeContextCurrent(m_pWindow); }
+
+  void releaseContext() { glfwMakeContextCurrent(nullptr); }
 
   void onResize(const ResizeCallback callback) {
     m_resizeCallback = callback;
@@ -98,8 +104,8 @@ public:
   }
 };
 
-Window::Window(const bool headless)
-    : m_pImpl(std::make_unique<Impl>(headless)) {}
+Window::Window(const bool headless, const bool debugContext)
+    : m_pImpl(std::make_unique<Impl>(headless, debugContext)) {}
 
 Window::~Window() noexcept = default;
 
@@ -120,7 +126,18 @@ void Window::onKeyEvent(const KeyEventCallback callback) {
   m_pImpl->onKeyEvent(callback);
 }
 
-void Window::update() { m_pImpl->update(); }
+void Window::update() {
+  m_pImpl->swapBuffers();
+  m_pImpl->pollEvents();
+}
+
+void Window::swapBuffers() { m_pImpl->swapBuffers(); }
+
+void Window::pollEvents() { m_pImpl->pollEvents(); }
+
+void Window::makeContextCurrent() { m_pImpl->makeContextCurrent(); }
+
+void Window::releaseContext() { m_pImpl->releaseContext(); }
 
 } // namespace renderer
 } // namespace mata
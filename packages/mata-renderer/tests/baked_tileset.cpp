@@ -0,0 +1,92 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include <mata/core/little_endian.hpp>
+#include <mata/core/types.hpp>
+#include <mata/renderer/baked_tileset.hpp>
+#include <mata/renderer/texture.hpp>
+#include <mata/renderer/tileset.hpp>
+
+namespace {
+
+// Offsets into the header documented in baked_tileset.hpp.
+constexpr std::size_t FORMAT_OFFSET = 12;
+constexpr std::size_t TILE_HEIGHT_OFFSET = 20;
+constexpr std::size_t N_COLUMNS_OFFSET = 24;
+constexpr std::size_t N_ROWS_OFFSET = 28;
+
+// Three 4x4 tiles in a row, stacked 4x12 once baked.
+mata::renderer::Tileset makeTileset() {
+  auto rgba = mata::core::bytes(12 * 4 * 4);
+  for (auto i = std::size_t{0}; i < rgba.size(); i++) {
+    rgba[i] = static_cast<mata::core::byte>(i * 7);
+  }
+  return mata::renderer::Tileset(
+      {4, 4}, {3, 1}, mata::renderer::Texture({12, 4}, std::move(rgba)));
+}
+
+void writeU32(mata::core::bytes &file, const std::size_t offset,
+              const std::uint32_t value) {
+  mata::core::writeLittleEndian(file.data() + offset, value);
+}
+
+} // namespace
+
+TEST_CASE("Baked tilesets load what was baked", "[baked_tileset]") {
+  const auto tileset = makeTileset();
+  const auto format = GENERATE(mata::renderer::TextureFormat::Bc1,
+                               mata::renderer::TextureFormat::Bc3);
+
+  const auto baked = mata::renderer::loadBakedTileset(
+      mata::renderer::bakeTileset(tileset));
+  REQUIRE(baked.texture().format() == mata::renderer::TextureFormat::Rgba8);
+  const auto expected = tileset.asLinearBytes();
+  const auto actual = baked.asLinearBytes();
+  REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin(),
+                     expected.end()));
+
+  const auto compressed = mata::renderer::loadBakedTileset(
+      mata::renderer::compressTileset(tileset, format));
+  REQUIRE(compressed.texture().format() == format);
+  REQUIRE(compressed.tileSize().nColumns == 4);
+  REQUIRE(compressed.dimensions().nColumns == 3);
+}
+
+TEST_CASE("Corrupt baked tilesets are rejected", "[baked_tileset]") {
+  auto file = mata::renderer::compressTileset(
+      makeTileset(), mata::renderer::TextureFormat::Bc1);
+  REQUIRE_NOTHROW(mata::renderer::loadBakedTileset(file));
+
+  SECTION("bad magic") { file[0] = 'X'; }
+  SECTION("bad format") { writeU32(file, FORMAT_OFFSET, 7); }
+  SECTION("tiles that aren't whole blocks") {
+    // Two 4x6 tiles stack into the same 4x12 image as three 4x4 ones, so
+    // only the tile size gives them away.
+    writeU32(file, TILE_HEIGHT_OFFSET, 6);
+    writeU32(file, N_COLUMNS_OFFSET, 2);
+    writeU32(file, N_ROWS_OFFSET, 1);
+  }
+  SECTION("truncated header") { file.resize(20); }
+  SECTION("truncated layers") { file.pop_back(); }
+
+  REQUIRE_THROWS_AS(mata::renderer::loadBakedTileset(file),
+                    std::runtime_error);
+}
+
+TEST_CASE("Tiles that aren't whole blocks can't be compressed",
+          "[baked_tileset]") {
+  const auto texture =
+      mata::renderer::Texture({4, 12}, mata::core::bytes(4 * 12 * 4));
+  const auto tileset = mata::renderer::Tileset({4, 6}, {1, 2}, texture);
+  REQUIRE_THROWS_AS(mata::renderer::compressTileset(
+                        tileset, mata::renderer::TextureFormat::Bc1),
+                    std::logic_error);
+}
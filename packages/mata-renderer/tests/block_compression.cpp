@@ -0,0 +1,100 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <mata/core/geometry.hpp>
+#include <mata/core/types.hpp>
+#include <mata/renderer/texture.hpp>
+
+#include "block_compression.hpp"
+
+namespace {
+
+constexpr auto SIZE = 8;
+constexpr auto N_COLOR_CHANNELS = 4;
+// Per channel, for colors and for BC3's interpolated alpha.
+constexpr auto COLOR_ERROR_BOUND = 24;
+constexpr auto ALPHA_ERROR_BOUND = 20;
+
+using Color = std::array<int, N_COLOR_CHANNELS>;
+
+// One 4x4 block of each kind: a gray gradient, a solid color, a checker of
+// opaque and fully transparent pixels, and an alpha gradient.
+Color sourcePixel(const int x, const int y) noexcept {
+  const auto n = (y % 4) * 4 + x % 4;
+  if (x < 4 && y < 4) {
+    const auto gray = 40 + 10 * n;
+    return {gray, gray, gray, 255};
+  }
+  if (y < 4) {
+    return {200, 100, 50, 255};
+  }
+  if (x < 4) {
+    return (x + y) % 2 != 0 ? Color{30, 200, 90, 255} : Color{0, 0, 0, 0};
+  }
+  return {120, 60, 220, 17 * n};
+}
+
+mata::core::bytes sourceImage() {
+  auto rgba = mata::core::bytes{};
+  for (auto y = 0; y < SIZE; y++) {
+    for (auto x = 0; x < SIZE; x++) {
+      for (const auto channel : sourcePixel(x, y)) {
+        rgba.push_back(static_cast<mata::core::byte>(channel));
+      }
+    }
+  }
+  return rgba;
+}
+
+} // namespace
+
+TEST_CASE("Block compression round trips", "[block_compression]") {
+  const auto format = GENERATE(mata::renderer::TextureFormat::Bc1,
+                               mata::renderer::TextureFormat::Bc3);
+  const auto rgba = sourceImage();
+  const auto blocks =
+      mata::renderer::compressBlocks(format, rgba, {SIZE, SIZE});
+  REQUIRE(blocks.size() ==
+          mata::renderer::compressedSize(format, {SIZE, SIZE}));
+  const auto decompressed =
+      mata::renderer::decompressBlocks(format, blocks, {SIZE, SIZE});
+  REQUIRE(decompressed.size() == rgba.size());
+
+  for (auto y = 0; y < SIZE; y++) {
+    for (auto x = 0; x < SIZE; x++) {
+      CAPTURE(x, y);
+      const auto source = sourcePixel(x, y);
+      const auto pPixel = decompressed.data() +
+                          (y * SIZE + x) * N_COLOR_CHANNELS;
+      const auto alpha = static_cast<int>(pPixel[3]);
+      if (format == mata::renderer::TextureFormat::Bc1) {
+        // One bit of alpha: transparent pixels lose their color.
+        REQUIRE(alpha == (source[3] < 128 ? 0 : 255));
+        if (alpha == 0) {
+          continue;
+        }
+      } else {
+        REQUIRE(std::abs(alpha - source[3]) <= ALPHA_ERROR_BOUND);
+      }
+      for (auto channel = 0; channel < 3; channel++) {
+        REQUIRE(std::abs(static_cast<int>(pPixel[channel]) -
+                         source[static_cast<std::size_t>(channel)]) <=
+                COLOR_ERROR_BOUND);
+      }
+    }
+  }
+}
+
+TEST_CASE("Block compression rejects partial blocks", "[block_compression]") {
+  const auto rgba = mata::core::bytes(6 * 4 * N_COLOR_CHANNELS);
+  REQUIRE_THROWS_AS(mata::renderer::compressBlocks(
+                        mata::renderer::TextureFormat::Bc1, rgba, {6, 4}),
+                    std::logic_error);
+}
@@ -0,0 +1,40 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <vector>
+
+#include <mata/core/types.hpp>
+#include <mata/renderer/texture.hpp>
+#include <mata/renderer/tile_id.hpp>
+#include <mata/renderer/tile_layer.hpp>
+#include <mata/renderer/tileset.hpp>
+
+TEST_CASE("Tile layer emptiness", "[tile_layer]") {
+  const auto texture = mata::renderer::Texture(
+      {2, 2}, mata::core::bytes(2 * 2 * 4));
+  const auto tileset = mata::renderer::Tileset({1, 1}, {2, 2}, texture);
+  // Two tiles, in the first chunk and in the last one, which the layer's
+  // edges cut short.
+  const auto tiles = std::vector<mata::renderer::PlacedTile>{
+      {{40, 5}, mata::renderer::TileId(3)},
+      {{99, 69}, mata::renderer::TileId(1)},
+  };
+  const auto storage = GENERATE(mata::renderer::TileStorage::Dense,
+                                mata::renderer::TileStorage::Sparse);
+  const auto layer =
+      mata::renderer::TileLayer({100, 70}, tileset, tiles, storage);
+
+  REQUIRE(layer.tileAt({40, 5}) == mata::renderer::TileId(3));
+  REQUIRE(layer.tileAt({0, 0}).isEmpty());
+
+  REQUIRE(layer.isEmptyIn({0, 0}, {32, 32}));
+  REQUIRE_FALSE(layer.isEmptyIn({32, 0}, {32, 32}));
+  REQUIRE(layer.isEmptyIn({41, 0}, {50, 60}));
+  // Rectangles are clipped to the layer.
+  REQUIRE_FALSE(layer.isEmptyIn({90, 60}, {32, 32}));
+  REQUIRE_FALSE(layer.isEmptyIn({-10, -10}, {51, 16}));
+  REQUIRE(layer.isEmptyIn({-5, -5}, {5, 100}));
+  REQUIRE(layer.isEmptyIn({100, 0}, {10, 10}));
+}
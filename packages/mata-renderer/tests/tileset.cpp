@@ -0,0 +1,82 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+#include <mata/core/geometry.hpp>
+#include <mata/core/types.hpp>
+#include <mata/renderer/texture.hpp>
+#include <mata/renderer/tileset.hpp>
+
+namespace {
+
+const auto N_COLOR_CHANNELS = 4;
+
+// The row by row transposition Tileset used before it cached its result.
+mata::core::bytes
+rowByRowLinearBytes(const mata::renderer::Tileset &tileset) {
+  const auto &texture = tileset.texture();
+  const auto textureBytes = texture.asBytes();
+  auto linearBytes = mata::core::bytes(textureBytes.size());
+
+  const auto textureDims = texture.dimensions();
+  const auto tilesetDims = tileset.dimensions();
+  const auto tileSize = tileset.tileSize();
+  const auto nBytesPerTexturePxRow = textureDims.nColumns * N_COLOR_CHANNELS;
+  const auto nBytesPerTilePxRow = tileSize.nColumns * N_COLOR_CHANNELS;
+  const auto nBytesPerTile = tileSize.nColumns * tileSize.nRows *
+                             N_COLOR_CHANNELS;
+  for (auto pxRow = 0; pxRow < textureDims.nRows; pxRow++) {
+    const auto rowBytesOffset = nBytesPerTexturePxRow * pxRow;
+    for (auto tileCol = 0; tileCol < tilesetDims.nColumns; tileCol++) {
+      const auto srcStartOffset = rowBytesOffset + nBytesPerTilePxRow * tileCol;
+      const auto srcEndOffset = srcStartOffset + nBytesPerTilePxRow;
+      const auto tileRow = pxRow / tileSize.nRows;
+      const auto destTileIndex = tileRow * tilesetDims.nColumns + tileCol;
+      const auto tilePxRow = pxRow % tileSize.nRows;
+      const auto destOffset =
+          (nBytesPerTile * destTileIndex) + (nBytesPerTilePxRow * tilePxRow);
+      std::copy(textureBytes.begin() + srcStartOffset,
+                textureBytes.begin() + srcEndOffset,
+                linearBytes.begin() + destOffset);
+    }
+  }
+  return linearBytes;
+}
+
+} // namespace
+
+TEST_CASE("Tileset linear bytes match the row by row transposition",
+          "[tileset]") {
+  // Large enough to be split between threads.
+  constexpr auto SIZE = 2048;
+  auto rgba = mata::core::bytes(static_cast<std::size_t>(SIZE) * SIZE *
+                                N_COLOR_CHANNELS);
+  for (auto i = std::size_t{0}; i < rgba.size(); i++) {
+    rgba[i] = static_cast<mata::core::byte>(i * 31 + i / 4096);
+  }
+  const auto tileset = mata::renderer::Tileset(
+      {16, 16}, {SIZE / 16, SIZE / 16},
+      mata::renderer::Texture({SIZE, SIZE}, std::move(rgba)));
+
+  const auto linearBytes = tileset.asLinearBytes();
+  const auto expectedBytes = rowByRowLinearBytes(tileset);
+  REQUIRE(std::equal(linearBytes.begin(), linearBytes.end(),
+                     expectedBytes.begin(), expectedBytes.end()));
+}
+
+TEST_CASE("Compressed tilesets are always stacked", "[tileset]") {
+  // Four 4x4 tiles of BC1 blocks, stacked, but given the default layout.
+  const auto texture = mata::renderer::Texture(
+      {4, 16}, mata::renderer::TextureFormat::Bc1, mata::core::bytes(4 * 8));
+  const auto tileset = mata::renderer::Tileset({4, 4}, {2, 2}, texture);
+  REQUIRE(tileset.layout() == mata::renderer::TileLayout::Stacked);
+
+  const auto linearBytes = tileset.asLinearBytes();
+  REQUIRE(linearBytes.data() == tileset.texture().asBytes().data());
+  REQUIRE(linearBytes.size() == 4 * 8);
+}
@@ -0,0 +1,82 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "noncopyable.hpp"
+
+namespace mata {
+namespace utils {
+
+// A queue handing values from producer threads to consumer threads that
+// holds at most capacity values, so that producers that get ahead block
+// instead of queueing without bound. Closing it wakes everyone up: pushes
+// then fail, and pops drain what's left before failing.
+template <typename T> class BoundedQueue final : noncopyable {
+  std::mutex m_mutex{};
+  std::condition_variable m_pushed{};
+  std::condition_variable m_popped{};
+  std::deque<T> m_values{};
+  std::size_t m_capacity;
+  bool m_closed = false;
+
+public:
+  explicit BoundedQueue(const std::size_t capacity) : m_capacity(capacity) {
+    if (capacity == 0) {
+      throw std::logic_error("bounded queue needs a capacity of at least 1");
+    }
+  }
+
+  // Waits for room; returns false without queueing if the queue is closed.
+  bool push(T value) {
+    {
+      auto lock = std::unique_lock<std::mutex>(m_mutex);
+      m_popped.wait(lock, [this]() {
+        return m_closed || m_values.size() < m_capacity;
+      });
+      if (m_closed) {
+        return false;
+      }
+      m_values.push_back(std::move(value));
+    }
+    m_pushed.notify_one();
+    return true;
+  }
+
+  // Waits for a value; returns nothing once the queue is closed and empty.
+  [[nodiscard]] std::optional<T> pop() {
+    auto value = std::optional<T>{};
+    {
+      auto lock = std::unique_lock<std::mutex>(m_mutex);
+      m_pushed.wait(lock, [this]() { return m_closed || !m_values.empty(); });
+      if (m_values.empty()) {
+        return value;
+      }
+      value.emplace(std::move(m_values.front()));
+      m_values.pop_front();
+    }
+    m_popped.notify_one();
+    return value;
+  }
+
+  void close() {
+    {
+      auto lock = std::lock_guard<std::mutex>(m_mutex);
+      m_closed = true;
+    }
+    m_pushed.notify_all();
+    m_popped.notify_all();
+  }
+};
+
+} // namespace utils
+} // namespace mata
@@ -0,0 +1,123 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "noncopyable.hpp"
+
+namespace mata {
+namespace utils {
+
+// A fixed set of worker threads running submitted tasks in order. Tasks
+// still queued when the pool is destroyed are run before it returns.
+class ThreadPool final : noncopyable {
+  std::mutex m_mutex{};
+  std::condition_variable m_taskQueued{};
+  std::deque<std::function<void()>> m_tasks{};
+  bool m_stopping = false;
+  std::vector<std::thread> m_threads{};
+
+  void runTasks() {
+    while (true) {
+      auto task = std::function<void()>{};
+      {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        m_taskQueued.wait(lock,
+                          [this]() { return m_stopping || !m_tasks.empty(); });
+        if (m_tasks.empty()) {
+          return;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+public:
+  [[nodiscard]] static std::size_t defaultSize() noexcept {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  explicit ThreadPool(const std::size_t nThreads = defaultSize()) {
+    if (nThreads == 0) {
+      throw std::logic_error("thread pool needs at least one thread");
+    }
+    m_threads.reserve(nThreads);
+    for (auto i = std::size_t{0}; i < nThreads; i++) {
+      m_threads.emplace_back([this]() { this->runTasks(); });
+    }
+  }
+
+  ~ThreadPool() noexcept {
+    {
+      auto lock = std::lock_guard<std::mutex>(m_mutex);
+      m_stopping = true;
+    }
+    m_taskQueued.notify_all();
+    for (auto &thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return m_threads.size(); }
+
+  // Queue a function to run on a worker. Its result, or the exception it
+  // threw, is delivered through the returned future.
+  template <typename Function>
+  [[nodiscard]] std::future<std::invoke_result_t<std::decay_t<Function>>>
+  submit(Function &&function) {
+    using Result = std::invoke_result_t<std::decay_t<Function>>;
+    // packaged_task is move only but std::function needs a copyable target.
+    auto pTask = std::make_shared<std::packaged_task<Result()>>(
+        std::forward<Function>(function));
+    auto future = pTask->get_future();
+    {
+      auto lock = std::lock_guard<std::mutex>(m_mutex);
+      m_tasks.emplace_back([pTask]() { (*pTask)(); });
+    }
+    m_taskQueued.notify_one();
+    return future;
+  }
+};
+
+// Call back with the result of each future as it becomes ready, in the order
+// they finish rather than the order they were created in. Exceptions stored
+// in a future are rethrown from here.
+template <typename T, typename Callback>
+void forEachReady(std::vector<std::future<T>> futures, Callback &&callback) {
+  constexpr auto POLL_INTERVAL = std::chrono::milliseconds(1);
+  while (!futures.empty()) {
+    const auto ready =
+        std::find_if(futures.begin(), futures.end(), [](const auto &future) {
+          return future.wait_for(std::chrono::seconds(0)) ==
+                 std::future_status::ready;
+        });
+    if (ready == futures.end()) {
+      futures.front().wait_for(POLL_INTERVAL);
+      continue;
+    }
+    auto future = std::move(*ready);
+    futures.erase(ready);
+    callback(future.get());
+  }
+}
+
+} // namespace utils
+} // namespace mata
@@ -0,0 +1,292 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <glbinding/gl33core/gl.h>
+#include <glbinding/glbinding.h>
+
+#include <mata/core/geometry.hpp>
+#include <mata/platform/process.hpp>
+#include <mata/platform/virtual_file_system.hpp>
+#include <mata/renderer/camera.hpp>
+#include <mata/renderer/renderer.hpp>
+#include <mata/renderer/tile_id.hpp>
+#include <mata/renderer/tile_layer.hpp>
+#include <mata/renderer/tileset.hpp>
+#include <mata/renderer/window.hpp>
+
+#include "config.hpp"
+#include "fixtures.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using fmilliseconds = std::chrono::duration<double, std::milli>;
+using mata::renderer::LayerRenderMode;
+using mata::renderer::TileId;
+using mata::renderer::TileStorage;
+
+constexpr auto DEFAULT_N_FRAMES = 120;
+// Frames advance the camera by a fixed step, so that runs are repeatable
+// however fast they render.
+constexpr auto FRAME_SECONDS = 1.0f / 60.0f;
+constexpr auto TILE_SIZE = 16;
+constexpr auto TILESET_SIZE = 8;
+
+struct Scenario {
+  const char *name;
+  mata::core::GridDimensions2d mapSize;
+  int nLayers;
+  // Layers are spread over this many distinct tilesets.
+  int nTilesets;
+  LayerRenderMode mode;
+  // Below 1 shows more tiles: at 1 the screen is two tiles across.
+  float zoom;
+  // Tiles a second the camera moves, diagonally across the map.
+  float panSpeed;
+  // Below 1, only this fraction of the map's blocks hold tiles, as in
+  // decoration layers, and the layers are built from their placed tiles.
+  float coverage = 1.0f;
+  TileStorage storage = TileStorage::Dense;
+};
+
+const auto SCENARIOS = std::vector<Scenario>{
+    {"map-16", {16, 16}, 1, 1, LayerRenderMode::Mesh, 1.0f / 8.0f, 0.0f},
+    {"map-256", {256, 256}, 1, 1, LayerRenderMode::Mesh, 1.0f / 32.0f, 0.0f},
+    {"map-1024", {1024, 1024}, 1, 1, LayerRenderMode::Mesh, 1.0f / 32.0f,
+     0.0f},
+    {"map-4096", {4096, 4096}, 1, 1, LayerRenderMode::Mesh, 1.0f / 32.0f,
+     0.0f},
+    {"map-4096-tilemap", {4096, 4096}, 1, 1, LayerRenderMode::TileMap,
+     1.0f / 32.0f, 0.0f},
+    {"layers-16", {256, 256}, 16, 1, LayerRenderMode::Mesh, 1.0f / 32.0f,
+     0.0f},
+    {"tilesets-16", {256, 256}, 16, 16, LayerRenderMode::Mesh, 1.0f / 32.0f,
+     0.0f},
+    {"pan-1024", {1024, 1024}, 1, 1, LayerRenderMode::Mesh, 1.0f / 32.0f,
+     32.0f},
+    {"pan-4096-zoomed-out", {4096, 4096}, 1, 1, LayerRenderMode::Mesh,
+     1.0f / 256.0f, 256.0f},
+    {"decoration-4096", {4096, 4096}, 1, 1, LayerRenderMode::Mesh,
+     1.0f / 256.0f, 0.0f, 0.1f},
+    {"decoration-4096-sparse", {4096, 4096}, 1, 1, LayerRenderMode::Mesh,
+     1.0f / 256.0f, 0.0f, 0.1f, TileStorage::Sparse},
+};
+
+struct Result {
+  const Scenario *pScenario;
+  fmilliseconds initTime;
+  fmilliseconds loadTime;
+  // Sorted, for percentiles.
+  std::vector<fmilliseconds> frameTimes;
+  std::size_t glCallsPerFrame;
+  mata::renderer::Renderer::FrameStats totalStats;
+  std::size_t peakRss;
+};
+
+mata::renderer::TileLayer makeLayer(const Scenario &scenario,
+                                    const mata::renderer::Tileset &tileset,
+                                    const int seed) {
+  if (scenario.coverage < 1.0f) {
+    return mata::renderer::TileLayer(
+        scenario.mapSize, tileset,
+        mata::benchmarks::decorationTiles(scenario.mapSize,
+                                          tileset.dimensions(),
+                                          scenario.coverage, seed),
+        scenario.storage);
+  }
+  auto tiles = std::vector<TileId>{};
+  tiles.reserve(static_cast<std::size_t>(scenario.mapSize.nColumns) *
+                static_cast<std::size_t>(scenario.mapSize.nRows));
+  for (auto j = 0; j < scenario.mapSize.nRows; j++) {
+    for (auto i = 0; i < scenario.mapSize.nColumns; i++) {
+      const auto n = i * 7 + j * 13 + seed;
+      tiles.push_back(TileId(n % (TILESET_SIZE * TILESET_SIZE)));
+    }
+  }
+  return mata::renderer::TileLayer(scenario.mapSize, tileset, tiles,
+                                   scenario.storage);
+}
+
+Result runScenario(const Scenario &scenario, const int nFrames) {
+  auto result = Result{};
+  result.pScenario = &scenario;
+
+  const auto pVfs = std::make_shared<mata::platform::VirtualFileSystem>(
+      MATA_RESOURCES_PATH);
+  auto window = mata::renderer::Window(true);
+  auto params = mata::renderer::RendererParams{};
+  // Per call checks would dominate the timings.
+  params.errorCheckMode = mata::renderer::GlErrorCheckMode::PerFrame;
+
+  const auto initStartedAt = Clock::now();
+  auto renderer = mata::renderer::Renderer(window, pVfs, params);
+  result.initTime = Clock::now() - initStartedAt;
+
+  auto tilesets = std::vector<mata::renderer::Tileset>{};
+  for (auto n = 0; n < scenario.nTilesets; n++) {
+    // Each its own colours.
+    tilesets.push_back(mata::benchmarks::makeTileset(
+        TILE_SIZE * TILESET_SIZE, TILE_SIZE, n));
+  }
+  auto camera = mata::renderer::Camera();
+  camera.zoomBy(scenario.zoom);
+
+  const auto loadStartedAt = Clock::now();
+  for (auto layerN = 0; layerN < scenario.nLayers; layerN++) {
+    const auto &tileset =
+        tilesets[static_cast<std::size_t>(layerN % scenario.nTilesets)];
+    renderer.setLayer(static_cast<mata::renderer::Renderer::LayerIdx>(layerN),
+                      makeLayer(scenario, tileset, layerN), scenario.mode);
+  }
+  renderer.updateCamera(camera);
+  renderer.drawFrame();
+  gl::glFinish();
+  result.loadTime = Clock::now() - loadStartedAt;
+  window.swapBuffers();
+
+  const auto step = scenario.panSpeed * FRAME_SECONDS;
+  for (auto frame = 0; frame < nFrames; frame++) {
+    const auto frameStartedAt = Clock::now();
+    camera.translateBy({-step, step});
+    renderer.updateCamera(camera);
+    renderer.drawFrame();
+    window.swapBuffers();
+    result.frameTimes.push_back(Clock::now() - frameStartedAt);
+
+    const auto stats = renderer.frameStats();
+    auto &total = result.totalStats;
+    total.drawCalls += stats.drawCalls;
+    total.chunksDrawn += stats.chunksDrawn;
+    total.chunksCulled += stats.chunksCulled;
+    total.stateChanges += stats.stateChanges;
+    total.stateChangesAvoided += stats.stateChangesAvoided;
+    total.bytesStreamed += stats.bytesStreamed;
+  }
+  std::sort(result.frameTimes.begin(), result.frameTimes.end());
+
+  // Count calls over one more frame; the callback would skew the timings.
+  auto nGlCalls = std::size_t{0};
+  glbinding::setAfterCallback(
+      [&nGlCalls](const glbinding::FunctionCall &) { nGlCalls++; });
+  glbinding::setCallbackMask(glbinding::CallbackMask::After);
+  renderer.drawFrame();
+  glbinding::setCallbackMask(glbinding::CallbackMask::None);
+  glbinding::setAfterCallback(nullptr);
+  result.glCallsPerFrame = nGlCalls;
+
+  result.peakRss = mata::platform::peakResidentSetSize();
+  return result;
+}
+
+// Nearest rank percentile of sorted times.
+double percentile(const std::vector<fmilliseconds> &times,
+                  const double fraction) {
+  if (times.empty()) {
+    return 0.0;
+  }
+  const auto rank = static_cast<std::size_t>(
+      std::ceil(fraction * static_cast<double>(times.size())));
+  return times[std::clamp(rank, std::size_t{1}, times.size()) - 1].count();
+}
+
+std::string toJson(const Result &result) {
+  const auto &scenario = *result.pScenario;
+  const auto nFrames = static_cast<double>(
+      std::max(result.frameTimes.size(), std::size_t{1}));
+  const auto &total = result.totalStats;
+  return fmt::format(
+      R"({{"name":"{}","mapSize":[{},{}],"layers":{},"tilesets":{},)"
+      R"("mode":"{}","zoom":{},"panSpeed":{},)"
+      R"("initMs":{:.3f},"loadMs":{:.3f},)"
+      R"("frameMs":{{"p50":{:.3f},"p90":{:.3f},"p99":{:.3f},"max":{:.3f}}},)"
+      R"("glCallsPerFrame":{},"drawCallsPerFrame":{:.1f},)"
+      R"("chunksDrawnPerFrame":{:.1f},"chunksCulledPerFrame":{:.1f},)"
+      R"("stateChangesPerFrame":{:.1f},"stateChangesAvoidedPerFrame":{:.1f},)"
+      R"("bytesStreamedPerFrame":{:.1f},"peakRssBytes":{}}})",
+      scenario.name, scenario.mapSize.nColumns, scenario.mapSize.nRows,
+      scenario.nLayers, scenario.nTilesets,
+      scenario.mode == LayerRenderMode::TileMap ? "tilemap" : "mesh",
+      scenario.zoom, scenario.panSpeed, result.initTime.count(),
+      result.loadTime.count(), percentile(result.frameTimes, 0.5),
+      percentile(result.frameTimes, 0.9), percentile(result.frameTimes, 0.99),
+      result.frameTimes.empty() ? 0.0 : result.frameTimes.back().count(),
+      result.glCallsPerFrame, total.drawCalls / nFrames,
+      total.chunksDrawn / nFrames, total.chunksCulled / nFrames,
+      total.stateChanges / nFrames, total.stateChangesAvoided / nFrames,
+      static_cast<double>(total.bytesStreamed) / nFrames, result.peakRss);
+}
+
+void printUsage() {
+  std::cerr << "usage: mata_bench [--frames N] [--scenario NAME]...\n"
+               "scenarios:";
+  for (const auto &scenario : SCENARIOS) {
+    std::cerr << " " << scenario.name;
+  }
+  std::cerr << "\n";
+}
+
+} // namespace
+
+// Prints one JSON object with a result per scenario to stdout. Peak RSS is
+// the whole process's so far, so it only grows from scenario to scenario;
+// run one scenario at a time to measure each on its own.
+int main(int argc, char *argv[]) {
+  auto nFrames = DEFAULT_N_FRAMES;
+  auto scenarios = std::vector<const Scenario *>{};
+  try {
+    for (auto n = 1; n < argc; n++) {
+      const auto arg = std::string(argv[n]);
+      if (arg == "--frames" && n + 1 < argc) {
+        nFrames = std::stoi(argv[++n]);
+      } else if (arg == "--scenario" && n + 1 < argc) {
+        const auto name = std::string(argv[++n]);
+        const auto scenario = std::find_if(
+            SCENARIOS.begin(), SCENARIOS.end(),
+            [&name](const Scenario &s) { return s.name == name; });
+        if (scenario == SCENARIOS.end()) {
+          throw std::invalid_argument("unknown scenario " + name);
+        }
+        scenarios.push_back(&*scenario);
+      } else {
+        throw std::invalid_argument("unknown argument " + arg);
+      }
+    }
+  } catch (const std::exception &error) {
+    std::cerr << error.what() << "\n";
+    printUsage();
+    return 1;
+  }
+  if (scenarios.empty()) {
+    for (const auto &scenario : SCENARIOS) {
+      scenarios.push_back(&scenario);
+    }
+  }
+
+  try {
+    std::cout << "{\"frames\":" << nFrames << ",\"scenarios\":[";
+    for (auto n = std::size_t{0}; n < scenarios.size(); n++) {
+      std::cerr << "Running " << scenarios[n]->name << "\n";
+      std::cout << (n > 0 ? "," : "")
+                << toJson(runScenario(*scenarios[n], nFrames));
+    }
+    std::cout << "]}\n";
+  } catch (const std::exception &error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
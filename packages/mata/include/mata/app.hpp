@@ -4,17 +4,54 @@
 
 #pragma once
 
+#include <chrono>
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <vector>
 
+#include <mata/core/geometry.hpp>
+#include <mata/renderer/renderer.hpp>
+#include <mata/renderer/tile_id.hpp>
 #include <mata/utils/propagate_const.hpp>
 
 namespace mata {
 
 struct AppParams {
   bool headless = false;
+  // A resources directory or archive. Defaults to resources.pak next to the
+  // executable, or the resources directory there if it hasn't been packed.
   std::optional<std::filesystem::path> resourcesPath = {};
+  // Directories or archives mounted over the resources in order, so that
+  // files in later ones override those in earlier ones.
+  std::vector<std::filesystem::path> overlayPaths = {};
+  // A directory tilesets are baked into on the first run so that later runs
+  // can map them instead of decoding them. Nothing is cached if it's unset.
+  std::optional<std::filesystem::path> tilesetCachePath = {};
+  // Render tile layers by looking tiles up from a tile grid texture instead
+  // of drawing instanced quads.
+  bool tileMapLayers = false;
+  // The camera's starting zoom; below 1 starts zoomed out.
+  float cameraZoom = 1.0f;
+  // Sprites wandering over the map, drawn with the terrain tileset.
+  int nSprites = 0;
+  // Draw on a render thread that owns the GL context, fed snapshots of the
+  // simulation through a short queue, so that simulating the next frame
+  // overlaps drawing and presenting the last one. Costs up to two frames of
+  // latency; see App::frameLatency.
+  bool pipelinedRendering = false;
+  // Profile frames and write the last few here as a Chrome trace when run
+  // returns.
+  std::optional<std::filesystem::path> profileTracePath = {};
+  mata::renderer::RendererParams renderer = {};
+};
+
+// How long frames took from the simulation capturing them to being
+// presented, over every frame run has presented.
+struct FrameLatency {
+  unsigned int nFrames = 0;
+  std::chrono::microseconds average{0};
+  std::chrono::microseconds max{0};
 };
 
 class App final {
@@ -27,6 +64,15 @@ public:
 
   void stepFrame();
   void run();
+
+  // Change a tile of a layer from the simulation. Edits are carried to the
+  // renderer with the next frame's snapshot, in the order they were made,
+  // and checked against the layer when they're applied there.
+  void setTile(const mata::renderer::Renderer::LayerIdx layerN,
+               const mata::core::Index2d &index,
+               const mata::renderer::TileId tile);
+
+  [[nodiscard]] FrameLatency frameLatency() const noexcept;
 };
 
 } // namespace mata
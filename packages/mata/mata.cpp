@@ -2,25 +2,135 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
+#include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <exception>
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <system_error>
 
 #include <mata/app.hpp>
 #include <mata/exceptions.hpp>
 
+namespace {
+
+// Parse the whole of an environment variable's value. The standard parsers
+// alone ignore trailing junk and throw without naming the variable.
+template <typename Parse>
+auto parseNumber(const char *name, const std::string &value, Parse &&parse) {
+  auto nParsed = std::size_t{0};
+  try {
+    const auto number = parse(value, &nParsed);
+    if (nParsed == value.size()) {
+      return number;
+    }
+  } catch (const std::logic_error &) {
+  }
+  throw std::invalid_argument(std::string(name) +
+                              " is not a number: " + value);
+}
+
+float parseCameraZoom(const std::string &value) {
+  const auto zoom = parseNumber(
+      "MATA_CAMERA_ZOOM", value,
+      [](const std::string &text, std::size_t *pNParsed) {
+        return std::stof(text, pNParsed);
+      });
+  if (!std::isfinite(zoom) || zoom <= 0.0f) {
+    throw std::invalid_argument(
+        "MATA_CAMERA_ZOOM must be a finite positive number: " + value);
+  }
+  return zoom;
+}
+
+int parseNSprites(const std::string &value) {
+  const auto nSprites = parseNumber(
+      "MATA_SPRITES", value,
+      [](const std::string &text, std::size_t *pNParsed) {
+        return std::stoi(text, pNParsed);
+      });
+  if (nSprites < 0) {
+    throw std::invalid_argument("MATA_SPRITES must not be negative: " +
+                                value);
+  }
+  return nSprites;
+}
+
+} // namespace
+
 int main() {
   auto params = mata::AppParams{};
   const auto resPath = std::getenv("RESOURECES_PATH");
   if (nullptr != resPath) {
     params.resourcesPath = std::string(resPath);
   }
+  const auto overlayPath = std::getenv("MATA_RESOURCES_OVERLAY");
+  if (nullptr != overlayPath) {
+    params.overlayPaths.push_back(std::filesystem::absolute(overlayPath));
+  }
+  const auto tilesetCachePath = std::getenv("MATA_TILESET_CACHE");
+  if (nullptr != tilesetCachePath) {
+    params.tilesetCachePath = std::filesystem::absolute(tilesetCachePath);
+  } else {
+    auto error = std::error_code();
+    const auto tempPath = std::filesystem::temp_directory_path(error);
+    if (!error) {
+      params.tilesetCachePath = tempPath / "mata" / "tilesets";
+    }
+  }
+  if (nullptr != std::getenv("MATA_TILEMAP_LAYERS")) {
+    params.tileMapLayers = true;
+  }
+  const auto profileTracePath = std::getenv("MATA_PROFILE_TRACE");
+  if (nullptr != profileTracePath) {
+    params.profileTracePath = std::filesystem::absolute(profileTracePath);
+  }
+  if (nullptr != std::getenv("MATA_PIPELINED")) {
+    params.pipelinedRendering = true;
+  }
+  if (nullptr != std::getenv("MATA_NO_MIPMAPS")) {
+    params.renderer.tilesetMipmaps = false;
+  }
+  const auto errorCheckMode = std::getenv("MATA_GL_ERROR_CHECK");
+  if (nullptr != errorCheckMode) {
+    const auto mode = std::string(errorCheckMode);
+    if (mode == "call") {
+      params.renderer.errorCheckMode =
+          mata::renderer::GlErrorCheckMode::PerCall;
+    } else if (mode == "debug") {
+      params.renderer.errorCheckMode =
+          mata::renderer::GlErrorCheckMode::DebugOutput;
+    } else if (mode == "frame") {
+      params.renderer.errorCheckMode =
+          mata::renderer::GlErrorCheckMode::PerFrame;
+    } else {
+      std::cerr << "Unknown MATA_GL_ERROR_CHECK mode: " << mode << "\n";
+      return 1;
+    }
+  }
 
   try {
+    const auto cameraZoom = std::getenv("MATA_CAMERA_ZOOM");
+    if (nullptr != cameraZoom) {
+      params.cameraZoom = parseCameraZoom(cameraZoom);
+    }
+    const auto nSprites = std::getenv("MATA_SPRITES");
+    if (nullptr != nSprites) {
+      params.nSprites = parseNSprites(nSprites);
+    }
+
     auto app = mata::App(params);
     app.run();
+    using milliseconds = std::chrono::duration<double, std::milli>;
+    const auto latency = app.frameLatency();
+    std::cout << "Frame latency over " << latency.nFrames
+              << " frames: average "
+              << milliseconds(latency.average).count() << " ms, max "
+              << milliseconds(latency.max).count() << " ms\n";
   } catch (const std::exception &error) {
     const auto errorMessage = mata::format_exception(error);
     std::cerr << errorMessage << "\n";
@@ -6,13 +6,20 @@
 
 in VertexData {
   vec3 tileCoords;
+  vec4 tint;
 } i;
 
 uniform sampler2DArray uTexture;
+// Fragments less opaque than this are discarded, so that sprites can be cut
+// out without blending.
+uniform float uAlphaCutoff;
 
 out vec4 outColor;
 
 void main()
 {
-  outColor = texture(uTexture, i.tileCoords);
+  outColor = texture(uTexture, i.tileCoords) * i.tint;
+  if (outColor.a < uAlphaCutoff) {
+    discard;
+  }
 }
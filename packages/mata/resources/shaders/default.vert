@@ -3,19 +3,27 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #version 330 core
-layout (location = 0) in vec2 inPosition;
-layout (location = 1) in vec2 inTextureCoords;
-layout (location = 2) in int  inTileIndex;
+// Per-vertex corner of the shared unit quad.
+layout (location = 0) in vec2  inCorner;
+// Per-instance tile grid position and packed tile id.
+layout (location = 1) in uvec2 inGridPosition;
+layout (location = 2) in uint  inTile;
 
 uniform mat4 viewMatrix;
 
+#include "tiles.glsl"
+
 out VertexData {
   vec3 tileCoords;
+  vec4 tint;
 } o;
 
 void main() {
   // Flip the y-coord so that we can use the convention that UV coords are from
   // top-to-bottom, instead of bottom-to-top which requires flipping textures.
-  o.tileCoords = vec3(inTextureCoords, inTileIndex);
-  gl_Position = viewMatrix * vec4(inPosition.x, -inPosition.y, 1.0, 1.0);
+  vec2 position = vec2(inGridPosition) + inCorner;
+  o.tileCoords = vec3(flipTile(inCorner, inTile),
+                      animateTile(int(inTile & TILE_INDEX_MASK)));
+  o.tint = vec4(1.0);
+  gl_Position = viewMatrix * vec4(position.x, -position.y, 1.0, 1.0);
 }
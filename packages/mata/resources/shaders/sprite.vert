@@ -0,0 +1,31 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#version 330 core
+// Per-vertex corner of the shared unit quad.
+layout (location = 0) in vec2  inCorner;
+// Per-instance sprite placement, tileset index, depth and tint.
+layout (location = 1) in vec2  inPosition;
+layout (location = 2) in vec2  inSize;
+layout (location = 3) in int   inTileIndex;
+layout (location = 4) in float inDepth;
+layout (location = 5) in vec4  inTint;
+
+uniform mat4 viewMatrix;
+
+out VertexData {
+  vec3 tileCoords;
+  vec4 tint;
+} o;
+
+void main() {
+  // Flip the y-coord the same way default.vert does for tiles.
+  vec2 position = inPosition + inCorner * inSize;
+  o.tileCoords = vec3(inCorner, inTileIndex);
+  o.tint = inTint;
+  gl_Position = viewMatrix * vec4(position.x, -position.y, 1.0, 1.0);
+  // Greater depths are nearer; depth 0 lies on the far plane, which the
+  // depth buffer is cleared to.
+  gl_Position.z = (1.0 - 2.0 * clamp(inDepth, 0.0, 1.0)) * gl_Position.w;
+}
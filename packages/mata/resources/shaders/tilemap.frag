@@ -0,0 +1,43 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#version 330 core
+
+uniform mat4 uInverseViewMatrix;
+uniform vec2 uViewportSize;
+uniform usampler2D uTileGrid;
+uniform sampler2DArray uTexture;
+
+#include "tiles.glsl"
+
+out vec4 outColor;
+
+void main()
+{
+  // Map the fragment back to tile space, undoing the view matrix and the
+  // y-flip that default.vert applies to tile positions.
+  vec2 ndc = gl_FragCoord.xy / uViewportSize * 2.0 - 1.0;
+  vec4 position = uInverseViewMatrix * vec4(ndc, 1.0, 1.0);
+  vec2 tilePosition = vec2(position.x, -position.y);
+
+  ivec2 tile = ivec2(floor(tilePosition));
+  if (any(lessThan(tile, ivec2(0))) ||
+      any(greaterThanEqual(tile, textureSize(uTileGrid, 0)))) {
+    discard;
+  }
+
+  uint tileId = texelFetch(uTileGrid, tile, 0).r;
+  if ((tileId & TILE_INDEX_MASK) == EMPTY_TILE_INDEX) {
+    discard;
+  }
+  int tileIndex = animateTile(int(tileId & TILE_INDEX_MASK));
+  // Use the gradients of the continuous tile position so that the jump in
+  // fract() at tile edges doesn't throw off level of detail selection. Flips
+  // only negate and swap them, which leaves their lengths, and so the level
+  // of detail, unchanged.
+  outColor = textureGrad(uTexture,
+                         vec3(flipTile(fract(tilePosition), tileId),
+                              tileIndex),
+                         dFdx(tilePosition), dFdy(tilePosition));
+}
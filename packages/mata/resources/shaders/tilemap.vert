@@ -0,0 +1,12 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#version 330 core
+
+void main() {
+  // A single triangle covering the whole screen, generated from the vertex id
+  // so that no vertex buffer is needed: (-1,-1), (3,-1), (-1,3).
+  vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+  gl_Position = vec4(position, 0.0, 1.0);
+}
@@ -0,0 +1,50 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Shared by the tile shaders through #include "tiles.glsl", which the
+// renderer expands when loading them.
+
+// The packed tile id constants FLIP_HORIZONTAL, FLIP_VERTICAL, FLIP_DIAGONAL,
+// TILE_INDEX_MASK and EMPTY_TILE_INDEX, which the renderer generates from
+// mata::renderer::TileId rather than reading a file.
+#include "tile_id.glsl"
+
+// Tile animation table: (first frame, frame count) for each tileset index
+// that has a header, followed by (tile index, end time in ms) for each frame.
+uniform isamplerBuffer uTileAnimations;
+uniform int uTimeMs;
+
+int animateTile(int tileIndex) {
+  if (tileIndex >= textureSize(uTileAnimations)) {
+    return tileIndex;
+  }
+  ivec2 header = texelFetch(uTileAnimations, tileIndex).xy;
+  if (header.y == 0) {
+    return tileIndex;
+  }
+  int lastFrame = header.x + header.y - 1;
+  int t = uTimeMs % texelFetch(uTileAnimations, lastFrame).y;
+  for (int frame = header.x; frame < lastFrame; ++frame) {
+    ivec2 entry = texelFetch(uTileAnimations, frame).xy;
+    if (t < entry.y) {
+      return entry.x;
+    }
+  }
+  return texelFetch(uTileAnimations, lastFrame).x;
+}
+
+// Map coordinates within a tile to where they sample the tile, flipping the
+// axes and then swapping them for a diagonal flip, as Tiled does.
+vec2 flipTile(vec2 uv, uint tile) {
+  if ((tile & FLIP_HORIZONTAL) != 0u) {
+    uv.x = 1.0 - uv.x;
+  }
+  if ((tile & FLIP_VERTICAL) != 0u) {
+    uv.y = 1.0 - uv.y;
+  }
+  if ((tile & FLIP_DIAGONAL) != 0u) {
+    uv = uv.yx;
+  }
+  return uv;
+}
@@ -3,21 +3,37 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
+#include <cmath>
 #include <exception>
+#include <filesystem>
 #include <fmt/format.h>
+#include <fstream>
+#include <future>
+#include <optional>
 #include <glbinding/glbinding.h>
 #include <glm/vec2.hpp>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <mata/core/geometry.hpp>
 #include <mata/core/time.hpp>
 #include <mata/platform/filesystem.hpp>
 #include <mata/platform/platform.hpp>
+#include <mata/renderer/asset_loader.hpp>
 #include <mata/renderer/camera.hpp>
+#include <mata/renderer/profiler.hpp>
 #include <mata/renderer/renderer.hpp>
+#include <mata/renderer/sprite.hpp>
+#include <mata/renderer/tile_id.hpp>
 #include <mata/renderer/tile_layer.hpp>
 #include <mata/renderer/window.hpp>
+#include <mata/utils/bounded_queue.hpp>
+#include <mata/utils/thread_pool.hpp>
 
 #include "mata/app.hpp"
 
@@ -25,33 +41,163 @@ namespace mata {
 
 using namespace mata::core::units;
 
+inline std::filesystem::path resourcesPath(const AppParams &params) {
+  if (params.resourcesPath) {
+    return *params.resourcesPath;
+  }
+  const auto archivePath = mata::platform::execDir() / "resources.pak";
+  if (std::filesystem::exists(archivePath)) {
+    return archivePath;
+  }
+  return mata::platform::execDir() / "resources";
+}
+
 inline std::shared_ptr<mata::platform::VirtualFileSystem>
 initVirtualFilesystem(const AppParams &params) {
-  const auto resourcesPath =
-      params.resourcesPath.value_or(mata::platform::execDir() / "resources");
-  return std::make_shared<mata::platform::VirtualFileSystem>(resourcesPath);
+  auto pVfs = std::make_shared<mata::platform::VirtualFileSystem>(
+      resourcesPath(params));
+  for (const auto &overlayPath : params.overlayPaths) {
+    pVfs->mount(overlayPath);
+  }
+  return pVfs;
+}
+
+inline mata::renderer::RendererParams
+rendererParams(mata::renderer::RendererParams params,
+               std::shared_ptr<mata::renderer::Profiler> pProfiler) {
+  params.pProfiler = std::move(pProfiler);
+  return params;
 }
 
 static constexpr auto SCROLL_SPEED = 2.0f;
+// How many times the view is scaled per second while zooming.
+static constexpr auto ZOOM_SPEED = 2.0f;
+
+using Clock = std::chrono::steady_clock;
+
+struct TileEdit {
+  mata::renderer::Renderer::LayerIdx layerN;
+  mata::core::Index2d index;
+  mata::renderer::TileId tile;
+};
+
+// Everything the renderer needs from the simulation to draw a frame, copied
+// out of it so that a render thread never reads state being simulated.
+struct FrameSnapshot {
+  mata::renderer::Camera camera;
+  std::chrono::milliseconds animationTime;
+  std::vector<mata::renderer::Sprite> sprites;
+  // Changes since the last snapshot, applied in order.
+  std::vector<TileEdit> tileEdits;
+  std::optional<std::pair<int, int>> resize;
+  unsigned int wireframeToggles;
+  Clock::time_point capturedAt;
+};
 
 class App::Impl final {
 private:
-  static constexpr auto SIMULATION_UPDATE_FREQ = 10_fms;
+  // Frames are interpolated between steps, so the simulation can run well
+  // below the display's refresh rate without stuttering.
+  static constexpr auto SIMULATION_UPDATE_FREQ = 20_fms;
+  // Snapshots queued for the render thread, besides the one it's drawing.
+  // The simulation runs at most this many frames ahead of the screen.
+  static constexpr auto N_QUEUED_SNAPSHOTS = std::size_t{2};
+
+  bool m_pipelinedRendering;
+  std::optional<std::filesystem::path> m_profileTracePath;
+  std::shared_ptr<mata::renderer::Profiler> m_pProfiler;
 
   std::shared_ptr<mata::platform::VirtualFileSystem> m_pVfs;
   mata::renderer::Window m_window;
   mata::renderer::Renderer m_renderer;
+  mata::renderer::AssetLoader m_assetLoader;
 
+  // The state before the last simulation step, which frames are
+  // interpolated from.
+  mata::renderer::Camera m_previousCamera{};
+  std::vector<mata::renderer::Sprite> m_previousSprites{};
   mata::renderer::Camera m_camera{};
   bool m_closeRequested = false;
   float m_cameraHorizontalAxis = 0.0f;
   float m_cameraVerticalAxis = 0.0f;
+  float m_cameraZoomAxis = 0.0f;
+
+  std::optional<mata::renderer::Tileset> m_spriteTileset{};
+  std::vector<mata::renderer::Sprite> m_sprites{};
+  std::vector<glm::vec2> m_spriteVelocities{};
+  fmilliseconds m_simulationTime{0};
+  Clock::time_point m_lastFrameStartedAt{};
+  fmilliseconds m_simulationTimeLeft{0};
+
+  std::vector<TileEdit> m_tileEdits{};
+  std::optional<std::pair<int, int>> m_pendingResize{};
+  unsigned int m_wireframeToggles = 0;
 
-  void initScene() {
-    const auto imageBytes = m_pVfs->readFile("tilesets/terrain.png");
-    const auto tilesetTexture = mata::renderer::Texture::fromPng(imageBytes);
-    const auto tileset =
-        mata::renderer::Tileset{{32, 32}, {2, 2}, tilesetTexture};
+  // Written by whichever thread renders, read once it's done.
+  unsigned int m_nFramesPresented = 0;
+  Clock::duration m_totalLatency{0};
+  Clock::duration m_maxLatency{0};
+
+  void initScene(const AppParams &params) {
+    // Tilesets are read and decoded on the loader's workers; each is uploaded
+    // as soon as it's ready, while the others are still decoding.
+    auto tilesets = std::vector<std::future<mata::renderer::Tileset>>{};
+    tilesets.push_back(m_assetLoader.loadTileset("tilesets/terrain.png",
+                                                 {32, 32}, {2, 2}));
+    mata::utils::forEachReady(
+        std::move(tilesets), [this, &params](const auto &tileset) {
+          this->initLayer(params, tileset);
+        });
+  }
+
+  // Scatter sprites over the layer, each heading its own way. The golden
+  // angle spreads them evenly without needing a random number generator, so
+  // every run draws the same scene.
+  void initSprites(const AppParams &params,
+                   const mata::renderer::Tileset &tileset) {
+    static constexpr auto GOLDEN_ANGLE = 2.39996323f;
+    m_spriteTileset.emplace(tileset);
+    const auto tilesetDims = tileset.dimensions();
+    for (auto n = 0; n < params.nSprites; n++) {
+      const auto angle = GOLDEN_ANGLE * static_cast<float>(n);
+      const auto radius = std::sqrt(static_cast<float>(n) /
+                                    static_cast<float>(params.nSprites));
+      auto sprite = mata::renderer::Sprite{};
+      sprite.position = {2.0f + 2.0f * radius * std::cos(angle),
+                         2.0f + 2.0f * radius * std::sin(angle)};
+      sprite.size = {0.25f, 0.25f};
+      sprite.tile = {n % tilesetDims.nColumns,
+                     (n / tilesetDims.nColumns) % tilesetDims.nRows};
+      sprite.depth = static_cast<float>(n % 16) / 16.0f;
+      m_sprites.push_back(sprite);
+      m_spriteVelocities.push_back({std::cos(angle), std::sin(angle)});
+    }
+  }
+
+  void updateSprites(const fmilliseconds dt) {
+    const auto secs = dt.count() / 1000.0f;
+    for (auto n = std::size_t{0}; n < m_sprites.size(); n++) {
+      auto &sprite = m_sprites[n];
+      auto &velocity = m_spriteVelocities[n];
+      sprite.position += velocity * secs;
+      // Bounce off the edges of the layer.
+      if (sprite.position.x < 0.0f || sprite.position.x > 4.0f) {
+        velocity.x = -velocity.x;
+      }
+      if (sprite.position.y < 0.0f || sprite.position.y > 4.0f) {
+        velocity.y = -velocity.y;
+      }
+    }
+  }
+
+  void initLayer(const AppParams &params,
+                 const mata::renderer::Tileset &terrain) {
+    // Alternate one of the terrain tiles; the shaders pick the frame, so
+    // this costs nothing per frame on the CPU.
+    auto tileset = terrain;
+    tileset.setAnimations({{{1, 0},
+                            {{{1, 0}, std::chrono::milliseconds{400}},
+                             {{0, 1}, std::chrono::milliseconds{400}}}}});
     const auto layer = mata::renderer::TileLayer{{4, 4},
                                                  tileset,
                                                  {
@@ -72,27 +218,47 @@ private:
                                                      {1, 2},
                                                      {1, 2},
                                                  }};
-    m_renderer.setLayer(0, layer);
+    m_renderer.setLayer(0, layer,
+                        params.tileMapLayers
+                            ? mata::renderer::LayerRenderMode::TileMap
+                            : mata::renderer::LayerRenderMode::Mesh);
+    if (params.nSprites > 0) {
+      initSprites(params, tileset);
+    }
   }
 
   void updateCamera(const fmilliseconds dt) {
     const auto secs = dt.count() / 1000.0f;
     m_camera.translateBy({secs * -SCROLL_SPEED * m_cameraHorizontalAxis,
                           secs * -SCROLL_SPEED * m_cameraVerticalAxis});
+    if (m_cameraZoomAxis != 0.0f) {
+      m_camera.zoomBy(std::pow(ZOOM_SPEED, secs * m_cameraZoomAxis));
+    }
   }
 
 public:
   Impl(const AppParams &params)
-      : m_pVfs(initVirtualFilesystem(params)), m_window(params.headless),
-        m_renderer(m_window, m_pVfs) {
+      : m_pipelinedRendering(params.pipelinedRendering),
+        m_profileTracePath(params.profileTracePath),
+        m_pProfiler(params.profileTracePath
+                        ? std::make_shared<mata::renderer::Profiler>()
+                        : nullptr),
+        m_pVfs(initVirtualFilesystem(params)),
+        m_window(params.headless,
+                 params.renderer.errorCheckMode ==
+                     mata::renderer::GlErrorCheckMode::DebugOutput),
+        m_renderer(m_window, m_pVfs,
+                   rendererParams(params.renderer, m_pProfiler)),
+        m_assetLoader(m_pVfs, params.tilesetCachePath) {
+    m_camera.zoomBy(params.cameraZoom);
     m_window.onResize([this](const int width, const int height) {
-      m_renderer.resize(width, height);
+      m_pendingResize = {width, height};
     });
     m_window.onWindowCloseRequested(
         [this]() { this->m_closeRequested = true; });
     m_window.onKeyEvent([this](const int key, const int action) {
       if (key == GLFW_KEY_X && action == GLFW_PRESS) {
-        m_renderer.toggleWireframeMode();
+        m_wireframeToggles++;
       }
 
       if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
@@ -114,42 +280,205 @@ public:
           (key == GLFW_KEY_RIGHT && action == GLFW_RELEASE)) {
         m_cameraHorizontalAxis -= 1.0f;
       }
+      if ((key == GLFW_KEY_PAGE_UP && action == GLFW_PRESS) ||
+          (key == GLFW_KEY_PAGE_DOWN && action == GLFW_RELEASE)) {
+        m_cameraZoomAxis += 1.0f;
+      }
+      if ((key == GLFW_KEY_PAGE_DOWN && action == GLFW_PRESS) ||
+          (key == GLFW_KEY_PAGE_UP && action == GLFW_RELEASE)) {
+        m_cameraZoomAxis -= 1.0f;
+      }
     });
-    initScene();
+    initScene(params);
+    m_previousCamera = m_camera;
+    m_previousSprites = m_sprites;
   }
 
-  void stepSimulation(const fmilliseconds dt) { updateCamera(dt); }
+  void stepSimulation(const fmilliseconds dt) {
+    const auto scope =
+        mata::renderer::Profiler::Scope(m_pProfiler.get(), "simulation step");
+    m_previousCamera = m_camera;
+    m_previousSprites = m_sprites;
+    updateCamera(dt);
+    updateSprites(dt);
+    m_simulationTime += dt;
+  }
 
-  void render() {
-    m_renderer.updateCamera(m_camera);
+  // Step the simulation through the time since the last frame started.
+  // Based on https://gafferongames.com/post/fix_your_timestep/.
+  void advanceSimulation() {
+    const auto frameStartedAt = Clock::now();
+    m_simulationTimeLeft += frameStartedAt - m_lastFrameStartedAt;
+    m_lastFrameStartedAt = frameStartedAt;
+    while (m_simulationTimeLeft >= SIMULATION_UPDATE_FREQ) {
+      m_simulationTimeLeft -= SIMULATION_UPDATE_FREQ;
+      this->stepSimulation(SIMULATION_UPDATE_FREQ);
+    }
+  }
+
+  // Capture the simulation alpha of the way from the previous step to the
+  // current one.
+  [[nodiscard]] FrameSnapshot takeSnapshot(const float alpha) {
+    auto sprites = m_sprites;
+    if (m_previousSprites.size() == sprites.size()) {
+      for (auto n = std::size_t{0}; n < sprites.size(); n++) {
+        const auto &previous = m_previousSprites[n].position;
+        sprites[n].position =
+            previous + (sprites[n].position - previous) * alpha;
+      }
+    }
+    const auto animationTime = std::max(
+        m_simulationTime - SIMULATION_UPDATE_FREQ * (1.0f - alpha), 0_fms);
+    return {mata::renderer::Camera::interpolate(m_previousCamera, m_camera,
+                                                alpha),
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                animationTime),
+            std::move(sprites),
+            std::exchange(m_tileEdits, {}),
+            std::exchange(m_pendingResize, std::nullopt),
+            std::exchange(m_wireframeToggles, 0u),
+            Clock::now()};
+  }
+
+  // How far the simulation is between its last step and its next one.
+  [[nodiscard]] float interpolationAlpha() const noexcept {
+    return m_simulationTimeLeft / SIMULATION_UPDATE_FREQ;
+  }
+
+  void render(const FrameSnapshot &snapshot) {
+    const auto scope =
+        mata::renderer::Profiler::Scope(m_pProfiler.get(), "render");
+    if (snapshot.resize) {
+      m_renderer.resize(snapshot.resize->first, snapshot.resize->second);
+    }
+    for (auto n = 0u; n < snapshot.wireframeToggles; n++) {
+      m_renderer.toggleWireframeMode();
+    }
+    for (const auto &edit : snapshot.tileEdits) {
+      m_renderer.setTile(edit.layerN, edit.index, edit.tile);
+    }
+    m_renderer.updateCamera(snapshot.camera);
+    m_renderer.setAnimationTime(snapshot.animationTime);
+    if (m_spriteTileset) {
+      m_renderer.submitSprites(*m_spriteTileset, snapshot.sprites);
+    }
     m_renderer.drawFrame();
-    m_window.update();
+    {
+      const auto swapScope =
+          mata::renderer::Profiler::Scope(m_pProfiler.get(), "swap");
+      m_window.swapBuffers();
+    }
+
+    const auto latency = Clock::now() - snapshot.capturedAt;
+    m_nFramesPresented++;
+    m_totalLatency += latency;
+    m_maxLatency = std::max(m_maxLatency, latency);
+    if (m_pProfiler) {
+      m_pProfiler->endFrame();
+    }
+  }
+
+  void runSynchronous() {
+    while (!m_closeRequested) {
+      this->advanceSimulation();
+      this->render(this->takeSnapshot(this->interpolationAlpha()));
+      m_window.pollEvents();
+    }
+  }
+
+  // The main thread keeps simulating and polling events, which GLFW only
+  // allows there, while the render thread draws and waits on vsync.
+  void runPipelined() {
+    auto snapshots = mata::utils::BoundedQueue<FrameSnapshot>(
+        N_QUEUED_SNAPSHOTS);
+    m_window.releaseContext();
+    auto rendered = std::async(std::launch::async, [this, &snapshots]() {
+      m_window.makeContextCurrent();
+      m_renderer.useOnCurrentThread();
+      try {
+        while (const auto snapshot = snapshots.pop()) {
+          this->render(*snapshot);
+        }
+      } catch (...) {
+        // Stop the simulation, which would otherwise wait for room forever.
+        snapshots.close();
+        m_window.releaseContext();
+        throw;
+      }
+      m_window.releaseContext();
+    });
+
+    auto error = std::exception_ptr{};
+    try {
+      while (!m_closeRequested) {
+        m_window.pollEvents();
+        this->advanceSimulation();
+        auto snapshot = this->takeSnapshot(this->interpolationAlpha());
+        const auto scope = mata::renderer::Profiler::Scope(
+            m_pProfiler.get(), "wait for renderer");
+        if (!snapshots.push(std::move(snapshot))) {
+          break;
+        }
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    snapshots.close();
+    rendered.wait();
+    // Take the context back so that GL objects are deleted on this thread.
+    m_window.makeContextCurrent();
+    m_renderer.useOnCurrentThread();
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    rendered.get();
   }
 
   void stepFrame() {
     this->stepSimulation(SIMULATION_UPDATE_FREQ);
-    this->render();
+    this->render(this->takeSnapshot(1.0f));
+    m_window.pollEvents();
   }
 
   void run() {
-    // Based on https://gafferongames.com/post/fix_your_timestep/.
-    auto lastFrameEndedAt = std::chrono::high_resolution_clock::now();
-    auto simulationTimeLeft = 0_fms;
-    while (!m_closeRequested) {
-      const auto currentFrameStartedAt =
-          std::chrono::high_resolution_clock::now();
-      const auto lastFrameDuration = currentFrameStartedAt - lastFrameEndedAt;
-
-      simulationTimeLeft += lastFrameDuration;
-      while (simulationTimeLeft >= SIMULATION_UPDATE_FREQ) {
-        simulationTimeLeft -= SIMULATION_UPDATE_FREQ;
-        this->stepSimulation(SIMULATION_UPDATE_FREQ);
-      }
+    m_lastFrameStartedAt = Clock::now();
+    m_simulationTimeLeft = 0_fms;
+    if (m_pipelinedRendering) {
+      this->runPipelined();
+    } else {
+      this->runSynchronous();
+    }
+    if (m_pProfiler) {
+      this->writeProfileTrace();
+    }
+  }
 
-      this->render();
+  void writeProfileTrace() const {
+    auto file = std::ofstream(*m_profileTracePath);
+    m_pProfiler->writeChromeTrace(file);
+    if (!file) {
+      throw std::runtime_error(fmt::format("failed to write profile to {0}",
+                                           m_profileTracePath->string()));
+    }
+  }
+
+  void setTile(const mata::renderer::Renderer::LayerIdx layerN,
+               const mata::core::Index2d &index,
+               const mata::renderer::TileId tile) {
+    m_tileEdits.push_back({layerN, index, tile});
+  }
 
-      lastFrameEndedAt = currentFrameStartedAt;
+  [[nodiscard]] FrameLatency frameLatency() const noexcept {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    auto latency = FrameLatency{};
+    latency.nFrames = m_nFramesPresented;
+    if (m_nFramesPresented > 0) {
+      latency.average =
+          duration_cast<microseconds>(m_totalLatency / m_nFramesPresented);
+      latency.max = duration_cast<microseconds>(m_maxLatency);
     }
+    return latency;
   }
 };
 
@@ -161,4 +490,14 @@ void App::stepFrame() { m_pImpl->stepFrame(); }
 
 void App::run() { m_pImpl->run(); }
 
+void App::setTile(const mata::renderer::Renderer::LayerIdx layerN,
+                  const mata::core::Index2d &index,
+                  const mata::renderer::TileId tile) {
+  m_pImpl->setTile(layerN, index, tile);
+}
+
+FrameLatency App::frameLatency() const noexcept {
+  return m_pImpl->frameLatency();
+}
+
 } // namespace mata
@@ -6,6 +6,7 @@
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch.hpp>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 
 #include <mata/app.hpp>
@@ -13,15 +14,51 @@
 
 #include "config.hpp"
 
-TEST_CASE("Smoke test", "[main]") {
-  auto params = mata::AppParams{};
+namespace {
+
+// Run a headless app, one frame by default. Errors are rethrown with their
+// nested causes in the message, which Catch would otherwise drop.
+void runSmokeTest(
+    mata::AppParams params,
+    const std::function<void(mata::App &)> &run = [](mata::App &app) {
+      app.stepFrame();
+    }) {
   params.headless = true;
   params.resourcesPath = MATA_RESOURCES_PATH;
   try {
     auto app = mata::App(params);
-    app.stepFrame();
+    run(app);
   } catch (const std::exception &error) {
     const auto message = mata::format_exception(error);
     throw std::runtime_error(message);
   }
 }
+
+} // namespace
+
+TEST_CASE("Smoke test", "[main]") { runSmokeTest(mata::AppParams{}); }
+
+TEST_CASE("Smoke test with sprites", "[main]") {
+  auto params = mata::AppParams{};
+  params.nSprites = 1000;
+  runSmokeTest(params);
+}
+
+TEST_CASE("Smoke test with tile map layers", "[main]") {
+  auto params = mata::AppParams{};
+  params.tileMapLayers = true;
+  runSmokeTest(params);
+}
+
+TEST_CASE("Smoke test with mesh layer tile edits", "[main]") {
+  // Emptying a cell removes its instance and placing a tile adds one back,
+  // so each edit lays out the layer's chunks again before its frame.
+  runSmokeTest(mata::AppParams{}, [](mata::App &app) {
+    app.setTile(0, {2, 2}, mata::renderer::TileId::empty());
+    app.stepFrame();
+    app.setTile(0, {2, 2}, mata::renderer::TileId(0));
+    app.stepFrame();
+    app.setTile(0, {2, 2}, mata::renderer::TileId::empty());
+    app.stepFrame();
+  });
+}